@@ -2,26 +2,111 @@
 #define UNITS_H
 
 #include <cstdint>
-#include <iostream>
-#include <ostream>
+#include <iterator>
+#include <numeric>
 #include <ratio>
 
+#ifdef UNITS_INSTRUMENT
+#include "UnitsInstrument.h"
+#endif
+
 namespace phy {
 
+  namespace details {
+
+    /*
+     * Packing of the seven exponents of a unit in a single integer
+     */
+
+    // Each exponent is a signed base-512 digit, so multiplying units is adding their codes
+    // Exponents are kept within +-127 while a digit holds +-255: adding or subtracting two
+    // codes never carries, the result is range-checked digit by digit in PackedUnit
+    inline constexpr intmax_t dims_base = 512;
+    inline constexpr int dims_max = 127;
+    inline constexpr int dims_digit_max = 255;
+
+    constexpr intmax_t packDims(int metre, int kilogram, int second, int ampere, int kelvin, int mole, int candela) {
+        const int exponents[] = { candela, mole, kelvin, ampere, second, kilogram, metre };
+        intmax_t res = 0;
+        for (int e : exponents) {
+            res = res * dims_base + e;
+        }
+        return res;
+    }
+
+    constexpr int unpackDim(intmax_t dims, int index) {
+        for (int i = 0; ; ++i) {
+            intmax_t digit = ((dims % dims_base) + dims_base) % dims_base;
+            if (digit > dims_digit_max) {
+                digit -= dims_base;
+            }
+            if (i == index) {
+                return int(digit);
+            }
+            dims = (dims - digit) / dims_base;
+        }
+    }
+
+    template<int Metre, int Kilogram, int Second, int Ampere, int Kelvin, int Mole, int Candela>
+    struct packed_dims {
+        static_assert(Metre >= -dims_max && Metre <= dims_max && Kilogram >= -dims_max && Kilogram <= dims_max
+          && Second >= -dims_max && Second <= dims_max && Ampere >= -dims_max && Ampere <= dims_max
+          && Kelvin >= -dims_max && Kelvin <= dims_max && Mole >= -dims_max && Mole <= dims_max
+          && Candela >= -dims_max && Candela <= dims_max, "unit exponents must be between -127 and 127");
+
+        static constexpr intmax_t value = packDims(Metre, Kilogram, Second, Ampere, Kelvin, Mole, Candela);
+    };
+
+    // Whether every exponent of the code, times n, is within +-127, in a single pass over the digits
+    constexpr bool dimsFit(intmax_t dims, int n = 1) {
+        for (int i = 0; i < 7; ++i) {
+            intmax_t digit = ((dims % dims_base) + dims_base) % dims_base;
+            if (digit > dims_digit_max) {
+                digit -= dims_base;
+            }
+            if (digit * n < -dims_max || digit * n > dims_max) {
+                return false;
+            }
+            dims = (dims - digit) / dims_base;
+        }
+        return true;
+    }
+
+    // A power multiplies every digit and may carry, so each exponent is checked beforehand
+    template<typename U, int N>
+    struct power_dims {
+        static_assert(dimsFit(U::dims, N), "unit exponents must be between -127 and 127");
+
+        static constexpr intmax_t value = U::dims * N;
+    };
+
+  }
+
   /*
-   * A unit defined in terms of the base units
+   * A unit defined in terms of the base units, identified by its packed exponents
    */
-  template<int Metre, int Kilogram, int Second, int Ampere, int Kelvin, int Mole, int Candela>
-  struct Unit {
-    static constexpr int metre = Metre;
-    static constexpr int kilogram = Kilogram;
-    static constexpr int second = Second;
-    static constexpr int ampere = Ampere;
-    static constexpr int kelvin = Kelvin;
-    static constexpr int mole = Mole;
-    static constexpr int candela = Candela;
+  template<intmax_t Dims>
+  struct PackedUnit {
+    static constexpr intmax_t dims = Dims;
+
+    static constexpr int metre = details::unpackDim(Dims, 0);
+    static constexpr int kilogram = details::unpackDim(Dims, 1);
+    static constexpr int second = details::unpackDim(Dims, 2);
+    static constexpr int ampere = details::unpackDim(Dims, 3);
+    static constexpr int kelvin = details::unpackDim(Dims, 4);
+    static constexpr int mole = details::unpackDim(Dims, 5);
+    static constexpr int candela = details::unpackDim(Dims, 6);
+
+    static_assert(details::dimsFit(Dims), "unit exponents must be between -127 and 127");
+
+    // Naming the member instantiates the unit, and so checks it
+    using type = PackedUnit;
   };
 
+  // The usual spelling with one exponent per base unit
+  template<int Metre, int Kilogram, int Second, int Ampere, int Kelvin, int Mole, int Candela>
+  using Unit = PackedUnit<details::packed_dims<Metre, Kilogram, Second, Ampere, Kelvin, Mole, Candela>::value>;
+
   /*
    * Various type aliases
    */
@@ -53,21 +138,29 @@ namespace phy {
 
     intmax_t value;
 
-    Qty() : value(0) {};
-    Qty(intmax_t v) : value(v) {};
+    constexpr Qty() : value(0) {};
+    constexpr Qty(intmax_t v) : value(v) {};
 
     template<typename ROther>
     Qty& operator+=(Qty<U, ROther> other) {
+#ifdef UNITS_INSTRUMENT
+        this->value += details::instrumentedConvert<ROther, R>(other.value);
+#else
         using ratio = std::ratio_divide<ROther,R>;
         this->value += other.value * ratio::num / ratio::den;
+#endif
 
         return *this;
     }
 
     template<typename ROther>
     Qty& operator-=(Qty<U, ROther> other) {
+#ifdef UNITS_INSTRUMENT
+        this->value -= details::instrumentedConvert<ROther, R>(other.value);
+#else
         using ratio = std::ratio_divide<ROther,R>;
         this->value -= other.value * ratio::num / ratio::den;
+#endif
 
         return *this;
     }
@@ -115,10 +208,14 @@ namespace phy {
       using FromRatio = R;
       using ToRatio = typename ResQty::Ratio;
 
-      using Conv = std::ratio_divide<FromRatio, ToRatio>;
-
       ResQty res;
+      // The product stays inline without UNITS_INSTRUMENT, a helper call gets folded later and worse
+#ifdef UNITS_INSTRUMENT
+      res.value = details::instrumentedConvert<FromRatio, ToRatio>(val.value);
+#else
+      using Conv = std::ratio_divide<FromRatio, ToRatio>;
       res.value = val.value * Conv::num / Conv::den;
+#endif
       return res;
   }
 
@@ -126,8 +223,30 @@ namespace phy {
   // Namespace for all auxiliary functions that we could need and to keep code clean
   namespace details {
 
-    template<typename R1, typename R2>
-    using smallest_ratio = std::conditional_t<std::ratio_less_v<R1, R2>, R1, R2>;
+    /*
+     * Exact common ratio, every quantity of the given ratios is a whole multiple of it
+     */
+
+    template<typename... R>
+    struct common_ratio;
+
+    template<typename R>
+    struct common_ratio<R> {
+        using type = R;
+    };
+
+    // One of the given ratios is kept as is when it already is the common one, so Foot and Inch give Inch
+    template<typename R1, typename R2, typename... Rest>
+    struct common_ratio<R1, R2, Rest...> {
+        using exact = std::ratio<std::gcd(R1::num, R2::num), std::lcm(R1::den, R2::den)>;
+        using head = std::conditional_t<std::ratio_equal_v<exact, R1>, R1,
+          std::conditional_t<std::ratio_equal_v<exact, R2>, R2, exact>>;
+        using type = typename common_ratio<head, Rest...>::type;
+    };
+
+    // Both quantities converted to their exact common ratio only need a multiplication
+    template<typename U, typename R1, typename R2>
+    using common_qty = Qty<U, typename common_ratio<R1, R2>::type>;
 
   }
 
@@ -139,7 +258,7 @@ namespace phy {
 
   template<typename U, typename R1, typename R2>
   bool operator==(Qty<U, R1> q1, Qty<U, R2> q2) {
-      using CommonQty = Qty<U, details::smallest_ratio<R1, R2>>;
+      using CommonQty = details::common_qty<U, R1, R2>;
       CommonQty val1 = qtyCast<CommonQty>(q1);
       CommonQty val2 = qtyCast<CommonQty>(q2);
       return val1.value == val2.value;
@@ -152,7 +271,7 @@ namespace phy {
 
   template<typename U, typename R1, typename R2>
   bool operator<(Qty<U, R1> q1, Qty<U, R2> q2) {
-      using CommonQty = Qty<U, details::smallest_ratio<R1, R2>>;
+      using CommonQty = details::common_qty<U, R1, R2>;
       CommonQty val1 = qtyCast<CommonQty>(q1);
       CommonQty val2 = qtyCast<CommonQty>(q2);
       return val1.value < val2.value;
@@ -165,7 +284,7 @@ namespace phy {
 
   template<typename U, typename R1, typename R2>
   bool operator>(Qty<U, R1> q1, Qty<U, R2> q2) {
-      using CommonQty = Qty<U, details::smallest_ratio<R1, R2>>;
+      using CommonQty = details::common_qty<U, R1, R2>;
       CommonQty val1 = qtyCast<CommonQty>(q1);
       CommonQty val2 = qtyCast<CommonQty>(q2);
       return val1.value > val2.value;
@@ -205,35 +324,256 @@ namespace phy {
   }
 
 
+  // The exponents of the units are packed, they are added or subtracted in one go
+  // The ratios are combined at compile time, only the values are multiplied or divided
+
   template<typename U1, typename R1, typename U2, typename R2>
   auto operator*(Qty<U1,R1> q1, Qty<U2,R2> q2) {
-      using unitRes = Unit<U1::metre+U2::metre,U1::kilogram+U2::kilogram,
-      U1::second+U2::second,U1::ampere+U2::ampere,
-      U1::kelvin+U2::kelvin,U1::mole+U2::mole,
-      U1::candela+U2::candela>;
+      using unitRes = typename PackedUnit<U1::dims + U2::dims>::type;
 
       using ratioRes = std::ratio_multiply<R1,R2>;
 
-      intmax_t res = (q1.value * ratioRes::num/ratioRes::den) * (q2.value* ratioRes::num/ratioRes::den);
+      intmax_t res = q1.value * q2.value;
 
       return Qty<unitRes,ratioRes>(res);
   }
 
   template<typename U1, typename R1, typename U2, typename R2>
   auto operator/(Qty<U1, R1> q1, Qty<U2, R2> q2) {
-      using unitRes = Unit<U1::metre-U2::metre,U1::kilogram-U2::kilogram,
-      U1::second-U2::second,U1::ampere-U2::ampere,
-      U1::kelvin-U2::kelvin,U1::mole-U2::mole,
-      U1::candela-U2::candela>;
+      using unitRes = typename PackedUnit<U1::dims - U2::dims>::type;
 
       using ratioRes = std::ratio_divide<R1,R2>;
 
-      intmax_t res = (q1.value * ratioRes::num/ratioRes::den) / (q2.value* ratioRes::num/ratioRes::den);
+      intmax_t res = q1.value / q2.value;
 
       return Qty<unitRes,ratioRes>(res);
   }
 
 
+  namespace details {
+
+    /*
+     * Integer roots, rounded towards zero
+     */
+
+    // Newton's iteration from a power of two above the root, a handful of steps for any intmax_t
+    constexpr intmax_t isqrt(intmax_t v) {
+        if (v < 2) {
+            return v < 0 ? 0 : v;
+        }
+
+        int bits = 0;
+        for (intmax_t tmp = v; tmp != 0; tmp >>= 1) {
+            ++bits;
+        }
+
+        intmax_t x = intmax_t(1) << ((bits + 1) / 2);
+        intmax_t y = (x + v / x) / 2;
+        while (y < x) {
+            x = y;
+            y = (x + v / x) / 2;
+        }
+        return x;
+    }
+
+    // Sums of squares of any intmax_t go through 128 bits
+    using wide_uint = unsigned __int128;
+
+    constexpr wide_uint isqrtWide(wide_uint v) {
+        if (v < 2) {
+            return v;
+        }
+
+        int bits = 0;
+        for (wide_uint tmp = v; tmp != 0; tmp >>= 1) {
+            ++bits;
+        }
+
+        wide_uint x = wide_uint(1) << ((bits + 1) / 2);
+        wide_uint y = (x + v / x) / 2;
+        while (y < x) {
+            x = y;
+            y = (x + v / x) / 2;
+        }
+        return x;
+    }
+
+    // Roots too large for a quantity saturate
+    constexpr intmax_t narrowRoot(wide_uint root) {
+        return root > wide_uint(INTMAX_MAX) ? INTMAX_MAX : intmax_t(root);
+    }
+
+    // Bitwise cube root (Hacker's Delight), three bits of input per step
+    constexpr intmax_t icbrt(intmax_t v) {
+        uintmax_t x = v < 0 ? uintmax_t(0) - uintmax_t(v) : uintmax_t(v);
+        uintmax_t y = 0;
+        for (int s = 63; s >= 0; s -= 3) {
+            y <<= 1;
+            uintmax_t b = 3 * y * (y + 1) + 1;
+            if ((x >> s) >= b) {
+                x -= b << s;
+                ++y;
+            }
+        }
+        return v < 0 ? -intmax_t(y) : intmax_t(y);
+    }
+
+    constexpr intmax_t ipow(intmax_t v, int n) {
+        intmax_t res = 1;
+        for (int i = 0; i < n; ++i) {
+            res *= v;
+        }
+        return res;
+    }
+
+    /*
+     * Compile-time powers and roots of units and ratios
+     */
+
+    template<typename U, int N>
+    using unit_pow = PackedUnit<power_dims<U, N>::value>;
+
+    template<typename U, int N>
+    struct unit_root {
+        static_assert(U::metre % N == 0 && U::kilogram % N == 0 && U::second % N == 0
+          && U::ampere % N == 0 && U::kelvin % N == 0 && U::mole % N == 0 && U::candela % N == 0,
+          "root requires every unit exponent to be a multiple of the root degree");
+
+        using type = PackedUnit<U::dims / N>;
+    };
+
+    template<typename R, int N>
+    struct ratio_pow {
+        using type = std::ratio_multiply<R, typename ratio_pow<R, N-1>::type>;
+    };
+
+    template<typename R>
+    struct ratio_pow<R, 0> {
+        using type = std::ratio<1>;
+    };
+
+    template<typename R>
+    struct ratio_sqrt {
+        static constexpr intmax_t num = isqrt(R::num);
+        static constexpr intmax_t den = isqrt(R::den);
+
+        static_assert(num * num == R::num && den * den == R::den,
+          "sqrt requires a perfect square ratio, qtyCast to one first");
+
+        using type = std::ratio<num, den>;
+    };
+
+    template<typename R>
+    struct ratio_cbrt {
+        static constexpr intmax_t num = icbrt(R::num);
+        static constexpr intmax_t den = icbrt(R::den);
+
+        static_assert(num * num * num == R::num && den * den * den == R::den,
+          "cbrt requires a perfect cube ratio, qtyCast to one first");
+
+        using type = std::ratio<num, den>;
+    };
+
+  }
+
+  /*
+   * Powers and roots
+   */
+
+  // Exponents and ratios are computed at compile time, only the value is touched at runtime
+
+  template<int N, typename U, typename R>
+  auto pow(Qty<U, R> q) {
+      static_assert(N >= 0, "pow requires a non-negative exponent");
+
+      using unitRes = details::unit_pow<U, N>;
+      using ratioRes = typename details::ratio_pow<R, N>::type;
+
+      return Qty<unitRes, ratioRes>(details::ipow(q.value, N));
+  }
+
+  // Negative values have no square root and give zero
+  template<typename U, typename R>
+  auto sqrt(Qty<U, R> q) {
+      using unitRes = typename details::unit_root<U, 2>::type;
+      using ratioRes = typename details::ratio_sqrt<R>::type;
+
+      return Qty<unitRes, ratioRes>(details::isqrt(q.value));
+  }
+
+  template<typename U, typename R>
+  auto cbrt(Qty<U, R> q) {
+      using unitRes = typename details::unit_root<U, 3>::type;
+      using ratioRes = typename details::ratio_cbrt<R>::type;
+
+      return Qty<unitRes, ratioRes>(details::icbrt(q.value));
+  }
+
+  namespace details {
+
+    template<typename It>
+    wide_uint squareOf(It it) {
+        const uintmax_t v = it->value < 0 ? 0 - uintmax_t(it->value) : uintmax_t(it->value);
+        return wide_uint(v) * v;
+    }
+
+    // Sum of the squares on 128 bits, saturated and reported when it does not fit
+    template<typename It>
+    bool sumSquares(It first, It last, wide_uint& res) {
+        res = 0;
+        for (; first != last; ++first) {
+            if (__builtin_add_overflow(res, squareOf(first), &res)) {
+                res = ~wide_uint(0);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Mean of the squares rounded down, each square is divided first when the sum does not fit
+    template<typename It>
+    wide_uint meanSquares(It first, It last, wide_uint count) {
+        wide_uint sum;
+        if (sumSquares(first, last, sum)) {
+            return sum / count;
+        }
+        wide_uint quotients = 0;
+        wide_uint remainders = 0;
+        for (; first != last; ++first) {
+            const wide_uint square = squareOf(first);
+            quotients += square / count;
+            remainders += square % count;
+        }
+        return quotients + remainders / count;
+    }
+
+  }
+
+  /*
+   * Bulk functions over contiguous ranges of quantities
+   */
+
+  // Euclidean norm of the range, in the unit and ratio of its elements, saturated to INTMAX_MAX
+  template<typename It>
+  auto norm(It first, It last) {
+      using QtyRes = typename std::iterator_traits<It>::value_type;
+      details::wide_uint sum;
+      details::sumSquares(first, last, sum);
+      return QtyRes(details::narrowRoot(details::isqrtWide(sum)));
+  }
+
+  // Root mean square of the range, zero if it is empty
+  template<typename It>
+  auto rms(It first, It last) {
+      using QtyRes = typename std::iterator_traits<It>::value_type;
+      const auto count = std::distance(first, last);
+      if (count == 0) {
+          return QtyRes();
+      }
+      return QtyRes(details::narrowRoot(details::isqrtWide(details::meanSquares(first, last, details::wide_uint(count)))));
+  }
+
+
   namespace literals {
 
     /*
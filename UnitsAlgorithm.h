@@ -0,0 +1,216 @@
+#ifndef UNITS_ALGORITHM_H
+#define UNITS_ALGORITHM_H
+
+#include "Units.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <numeric>
+#include <ranges>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace phy {
+
+  namespace details {
+
+    template<typename Range>
+    using range_qty = std::ranges::range_value_t<Range>;
+
+    /*
+     * LSD radix sort on keys where the sign bit is flipped so that unsigned order is signed order
+     */
+
+    inline constexpr uintmax_t sign_bit = uintmax_t(1) << 63;
+
+    // Below this many keys a single thread is faster than spawning more
+    inline constexpr std::size_t parallel_threshold = std::size_t(1) << 18;
+
+    inline uintmax_t toKey(intmax_t v) {
+        return uintmax_t(v) ^ sign_bit;
+    }
+
+    inline intmax_t fromKey(uintmax_t k) {
+        return intmax_t(k ^ sign_bit);
+    }
+
+    // Calls fn(t) for every chunk t, the calling thread takes the first chunk
+    template<typename Fn>
+    void forEachChunk(unsigned chunks, Fn fn) {
+        std::vector<std::thread> workers;
+        for (unsigned t = 1; t < chunks; ++t) {
+            workers.emplace_back(fn, t);
+        }
+        fn(0);
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    inline void radixSortKeys(std::vector<uintmax_t>& keys) {
+        const std::size_t n = keys.size();
+        unsigned chunks = 1;
+        if (n >= parallel_threshold) {
+            chunks = std::max(1u, std::thread::hardware_concurrency());
+        }
+        const std::size_t chunkSize = (n + chunks - 1) / chunks;
+
+        std::vector<uintmax_t> buffer(n);
+        std::vector<std::array<std::size_t, 256>> offsets(chunks);
+
+        for (int shift = 0; shift < 64; shift += 8) {
+            forEachChunk(chunks, [&](unsigned t) {
+                auto& count = offsets[t];
+                count.fill(0);
+                const std::size_t last = std::min(n, (t + 1) * chunkSize);
+                for (std::size_t i = t * chunkSize; i < last; ++i) {
+                    ++count[(keys[i] >> shift) & 0xff];
+                }
+            });
+
+            // Turn the counts into start positions, ordered by digit then by chunk to stay stable
+            std::size_t pos = 0;
+            bool trivial = false;
+            for (std::size_t d = 0; d < 256; ++d) {
+                const std::size_t start = pos;
+                for (unsigned t = 0; t < chunks; ++t) {
+                    const std::size_t count = offsets[t][d];
+                    offsets[t][d] = pos;
+                    pos += count;
+                }
+                trivial = trivial || pos - start == n;
+            }
+
+            // All keys share this digit so the pass would not move anything
+            if (trivial) {
+                continue;
+            }
+
+            forEachChunk(chunks, [&](unsigned t) {
+                auto& offset = offsets[t];
+                const std::size_t last = std::min(n, (t + 1) * chunkSize);
+                for (std::size_t i = t * chunkSize; i < last; ++i) {
+                    buffer[offset[(keys[i] >> shift) & 0xff]++] = keys[i];
+                }
+            });
+            keys.swap(buffer);
+        }
+    }
+
+  }
+
+  /*
+   * Sorting
+   */
+
+  // Sorts a contiguous range of quantities of a single ratio in place
+  template<std::ranges::contiguous_range Range>
+  void radixSort(Range&& values) {
+      using QtyElem = details::range_qty<Range>;
+
+      std::vector<uintmax_t> keys;
+      keys.reserve(std::ranges::size(values));
+      for (const QtyElem& q : values) {
+          keys.push_back(details::toKey(q.value));
+      }
+
+      details::radixSortKeys(keys);
+
+      auto it = std::ranges::begin(values);
+      for (uintmax_t key : keys) {
+          (it++)->value = details::fromKey(key);
+      }
+  }
+
+  // Gathers ranges of quantities of any ratio, converted exactly once to their common ratio, into one sorted vector
+  template<std::ranges::contiguous_range... Ranges>
+  auto sortedCommon(const Ranges&... ranges) {
+      using U = typename details::range_qty<std::tuple_element_t<0, std::tuple<Ranges...>>>::Unit;
+      static_assert((std::is_same_v<typename details::range_qty<Ranges>::Unit, U> && ...),
+        "sortedCommon requires identical units");
+
+      using QtyRes = Qty<U, typename details::common_ratio<typename details::range_qty<Ranges>::Ratio...>::type>;
+
+      std::vector<uintmax_t> keys;
+      keys.reserve((std::ranges::size(ranges) + ...));
+      auto append = [&keys](const auto& range) {
+          for (auto q : range) {
+              keys.push_back(details::toKey(qtyCast<QtyRes>(q).value));
+          }
+      };
+      (append(ranges), ...);
+
+      details::radixSortKeys(keys);
+
+      std::vector<QtyRes> res;
+      res.reserve(keys.size());
+      for (uintmax_t key : keys) {
+          res.emplace_back(details::fromKey(key));
+      }
+      return res;
+  }
+
+  /*
+   * Searching and merging sorted ranges
+   */
+
+  // The key is converted once, rounded up so that the search compares plain values
+  template<std::ranges::contiguous_range Range, typename U, typename R>
+  auto lowerBound(Range&& sorted, Qty<U, R> key) {
+      using QtyElem = details::range_qty<Range>;
+      static_assert(std::is_same_v<typename QtyElem::Unit, U>, "lowerBound requires identical units");
+
+      using Conv = std::ratio_divide<R, typename QtyElem::Ratio>;
+
+      const intmax_t scaled = key.value * Conv::num;
+      intmax_t threshold = scaled / Conv::den;
+      if (scaled % Conv::den > 0) {
+          ++threshold;
+      }
+
+      return std::ranges::lower_bound(sorted, threshold, std::ranges::less{}, &QtyElem::value);
+  }
+
+  // Merges two sorted ranges into a sorted vector in their exact common ratio
+  template<std::ranges::contiguous_range Range1, std::ranges::contiguous_range Range2>
+  auto merge(const Range1& sorted1, const Range2& sorted2) {
+      using Qty1 = details::range_qty<Range1>;
+      using Qty2 = details::range_qty<Range2>;
+      static_assert(std::is_same_v<typename Qty1::Unit, typename Qty2::Unit>, "merge requires identical units");
+
+      using QtyRes = Qty<typename Qty1::Unit, typename details::common_ratio<typename Qty1::Ratio, typename Qty2::Ratio>::type>;
+
+      std::vector<QtyRes> res;
+      res.reserve(std::ranges::size(sorted1) + std::ranges::size(sorted2));
+
+      auto it1 = std::ranges::begin(sorted1);
+      auto it2 = std::ranges::begin(sorted2);
+      const auto end1 = std::ranges::end(sorted1);
+      const auto end2 = std::ranges::end(sorted2);
+
+      while (it1 != end1 && it2 != end2) {
+          const QtyRes q1 = qtyCast<QtyRes>(*it1);
+          const QtyRes q2 = qtyCast<QtyRes>(*it2);
+          if (q2.value < q1.value) {
+              res.push_back(q2);
+              ++it2;
+          } else {
+              res.push_back(q1);
+              ++it1;
+          }
+      }
+      for (; it1 != end1; ++it1) {
+          res.push_back(qtyCast<QtyRes>(*it1));
+      }
+      for (; it2 != end2; ++it2) {
+          res.push_back(qtyCast<QtyRes>(*it2));
+      }
+      return res;
+  }
+
+}
+
+#endif // UNITS_ALGORITHM_H
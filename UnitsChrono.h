@@ -0,0 +1,127 @@
+#ifndef UNITS_CHRONO_H
+#define UNITS_CHRONO_H
+
+#include "Units.h"
+
+#include <chrono>
+#include <compare>
+#include <type_traits>
+
+namespace phy {
+
+  /*
+   * Conversions between times and std::chrono durations, the ratio is the period
+   */
+
+  template<typename R>
+  constexpr std::chrono::duration<intmax_t, R> toDuration(Qty<Second, R> time) {
+      return std::chrono::duration<intmax_t, R>(time.value);
+  }
+
+  template<typename Rep, typename Period>
+  constexpr Qty<Second, Period> fromDuration(std::chrono::duration<Rep, Period> duration) {
+      static_assert(std::is_integral_v<Rep>, "fromDuration requires an integer representation");
+      return Qty<Second, Period>(duration.count());
+  }
+
+  // Durations mix with quantities as times of the same ratio
+  template<typename U, typename R, typename Rep, typename Period>
+  auto operator*(Qty<U, R> q, std::chrono::duration<Rep, Period> duration) {
+      return q * fromDuration(duration);
+  }
+
+  template<typename U, typename R, typename Rep, typename Period>
+  auto operator/(Qty<U, R> q, std::chrono::duration<Rep, Period> duration) {
+      return q / fromDuration(duration);
+  }
+
+  /*
+   * A reading of a clock, kept as the time elapsed since its epoch
+   */
+
+  template<typename Clock, typename R = typename Clock::period>
+  struct Timestamp {
+    using ClockType = Clock;
+    using Ratio = R;
+
+    Qty<Second, R> sinceEpoch;
+
+    constexpr Timestamp() = default;
+    constexpr explicit Timestamp(Qty<Second, R> sinceEpoch) : sinceEpoch(sinceEpoch) {}
+
+    // Implicit, the cast is a no-op when R is the period of the clock
+    template<typename Duration>
+    constexpr Timestamp(std::chrono::time_point<Clock, Duration> tp)
+    : sinceEpoch(fromDuration(std::chrono::duration_cast<std::chrono::duration<intmax_t, R>>(tp.time_since_epoch()))) {}
+
+    static Timestamp now() {
+        return Clock::now();
+    }
+
+    constexpr std::chrono::time_point<Clock, std::chrono::duration<intmax_t, R>> timePoint() const {
+        return std::chrono::time_point<Clock, std::chrono::duration<intmax_t, R>>(toDuration(sinceEpoch));
+    }
+
+    template<typename ROther>
+    Timestamp& operator+=(Qty<Second, ROther> time) {
+        sinceEpoch += time;
+        return *this;
+    }
+
+    template<typename ROther>
+    Timestamp& operator-=(Qty<Second, ROther> time) {
+        sinceEpoch -= time;
+        return *this;
+    }
+
+    friend constexpr bool operator==(Timestamp t1, Timestamp t2) {
+        return t1.sinceEpoch.value == t2.sinceEpoch.value;
+    }
+
+    friend constexpr auto operator<=>(Timestamp t1, Timestamp t2) {
+        return t1.sinceEpoch.value <=> t2.sinceEpoch.value;
+    }
+  };
+
+  // The difference of two readings is a plain time, so `distance / (t2 - t1)` is a speed,
+  // but it truncates to zero with the nanosecond period of most clocks: see rate() below
+  template<typename Clock, typename R>
+  constexpr Qty<Second, R> operator-(Timestamp<Clock, R> t1, Timestamp<Clock, R> t2) {
+      return Qty<Second, R>(t1.sinceEpoch.value - t2.sinceEpoch.value);
+  }
+
+  template<typename Clock, typename R, typename ROther>
+  Timestamp<Clock, R> operator+(Timestamp<Clock, R> t, Qty<Second, ROther> time) {
+      return t += time;
+  }
+
+  template<typename Clock, typename R, typename ROther>
+  Timestamp<Clock, R> operator-(Timestamp<Clock, R> t, Qty<Second, ROther> time) {
+      return t -= time;
+  }
+
+  /*
+   * Rate of a quantity over a time, without the truncation of a fine clock period
+   */
+
+  // For times finer than a second, the quantity is first brought to the ratio of the time, at
+  // compile time, and the rate is in the ratio of the quantity per second: the quantity must then
+  // stay below INTMAX_MAX times that period. Coarser times are divided as is, the ratio is kept.
+  template<typename U, typename R, typename RTime>
+  auto rate(Qty<U, R> q, Qty<Second, RTime> time) {
+      if constexpr (std::ratio_less_v<RTime, std::ratio<1>>) {
+          using Scaled = Qty<U, std::ratio_multiply<R, RTime>>;
+          return qtyCast<Scaled>(q) / time;
+      } else {
+          return q / time;
+      }
+  }
+
+  template<typename U, typename R, typename Rep, typename Period>
+  auto rate(Qty<U, R> q, std::chrono::duration<Rep, Period> duration) {
+      return rate(q, fromDuration(duration));
+  }
+
+}
+
+#endif // UNITS_CHRONO_H
@@ -0,0 +1,8 @@
+# Package configuration of Units, installed along with the exported targets
+
+include(CMakeFindDependencyMacro)
+
+# Units::units links to Threads::Threads for the parallel algorithms
+find_dependency(Threads)
+
+include("${CMAKE_CURRENT_LIST_DIR}/UnitsTargets.cmake")
@@ -0,0 +1,198 @@
+#ifndef UNITS_EXACT_H
+#define UNITS_EXACT_H
+
+#include "Units.h"
+
+#include <compare>
+#include <numeric>
+#include <ratio>
+#include <stdexcept>
+#include <type_traits>
+
+namespace phy {
+
+  /*
+   * A quantity whose value is the fraction num / den, in the ratio R
+   *
+   * Nothing is divided until the value is stored back in a Qty, and the fraction is
+   * only reduced when compared or when a product would overflow.
+   */
+
+  template<class U, class R = std::ratio<1>>
+  struct ExactQty {
+    using Unit = U;
+    using Ratio = R;
+
+    intmax_t num;
+    intmax_t den;   // always positive
+
+    constexpr ExactQty() : num(0), den(1) {}
+    constexpr ExactQty(intmax_t v) : num(v), den(1) {}
+    constexpr ExactQty(intmax_t n, intmax_t d) : num(d < 0 ? -n : n), den(d < 0 ? -d : d) {}
+    constexpr ExactQty(Qty<U, R> q) : num(q.value), den(1) {}
+
+    constexpr ExactQty normalized() const {
+        const intmax_t g = std::gcd(num, den);
+        return ExactQty(num / g, den / g);
+    }
+  };
+
+  template<class U, class R>
+  constexpr ExactQty<U, R> exact(Qty<U, R> q) {
+      return ExactQty<U, R>(q);
+  }
+
+  namespace details {
+
+    template<typename Q>
+    struct is_exact_qty : std::false_type {};
+
+    template<typename U, typename R>
+    struct is_exact_qty<ExactQty<U, R>> : std::true_type {};
+
+    struct Fraction {
+      intmax_t num;
+      intmax_t den;
+    };
+
+    // Products of two intmax_t fit in 128 bits
+    using wide_int = __int128;
+
+    constexpr intmax_t narrowExact(wide_int v) {
+        if (v < INTMAX_MIN || v > INTMAX_MAX) {
+            throw std::overflow_error("exact quantity out of the range of intmax_t");
+        }
+        return intmax_t(v);
+    }
+
+    constexpr Fraction lowestTerms(intmax_t num, intmax_t den) {
+        const intmax_t g = std::gcd(num, den);
+        return { num / g, den / g };
+    }
+
+    // Reduction happens only when the plain products overflow: with both operands in lowest
+    // terms and cross reduced, the product is in lowest terms too
+    constexpr Fraction exactProduct(intmax_t n1, intmax_t d1, intmax_t n2, intmax_t d2) {
+        intmax_t num;
+        intmax_t den;
+        if (!__builtin_mul_overflow(n1, n2, &num) && !__builtin_mul_overflow(d1, d2, &den)) {
+            return { num, den };
+        }
+        const Fraction f1 = lowestTerms(n1, d1);
+        const Fraction f2 = lowestTerms(n2, d2);
+        const intmax_t g1 = std::gcd(f1.num, f2.den);
+        const intmax_t g2 = std::gcd(f2.num, f1.den);
+        return {
+          narrowExact(wide_int(f1.num / g1) * (f2.num / g2)),
+          narrowExact(wide_int(f1.den / g2) * (f2.den / g1)),
+        };
+    }
+
+    // Same denominators are just added, which is the usual case in a chain of sums
+    constexpr Fraction exactSum(intmax_t n1, intmax_t d1, intmax_t n2, intmax_t d2) {
+        intmax_t num;
+        if (d1 == d2 && !__builtin_add_overflow(n1, n2, &num)) {
+            return { num, d1 };
+        }
+        intmax_t a;
+        intmax_t b;
+        intmax_t den;
+        if (!__builtin_mul_overflow(n1, d2, &a) && !__builtin_mul_overflow(n2, d1, &b)
+            && !__builtin_mul_overflow(d1, d2, &den) && !__builtin_add_overflow(a, b, &num)) {
+            return { num, den };
+        }
+        // Over the lcm of the reduced denominators, then reduced by what is left of their gcd
+        const Fraction f1 = lowestTerms(n1, d1);
+        const Fraction f2 = lowestTerms(n2, d2);
+        const intmax_t g = std::gcd(f1.den, f2.den);
+        const wide_int sum = wide_int(f1.num) * (f2.den / g) + wide_int(f2.num) * (f1.den / g);
+        const intmax_t g2 = std::gcd(intmax_t(sum % g), g);
+        return { narrowExact(sum / g2), narrowExact(wide_int(f1.den / g) * (f2.den / g2)) };
+    }
+
+  }
+
+  /*
+   * Cast of an exact quantity, exact to another ExactQty and truncated once to a Qty
+   */
+
+  template<typename ResQty, typename U, typename R>
+  constexpr ResQty qtyCast(ExactQty<U, R> val) {
+      static_assert(std::is_same_v<typename ResQty::Unit, U>, "qtyCast requires identical units to convert to");
+
+      using Conv = std::ratio_divide<R, typename ResQty::Ratio>;
+      const details::Fraction res = details::exactProduct(val.num, val.den, Conv::num, Conv::den);
+
+      if constexpr (details::is_exact_qty<ResQty>::value) {
+          return ResQty(res.num, res.den);
+      } else {
+          return ResQty(res.num / res.den);
+      }
+  }
+
+  namespace details {
+
+    template<typename U, typename R1, typename R2>
+    using common_exact_qty = ExactQty<U, typename common_ratio<R1, R2>::type>;
+
+  }
+
+  /*
+   * Comparison operators, on the reduced fractions in the common ratio, cross multiplied in 128 bits
+   */
+
+  template<typename U, typename R1, typename R2>
+  constexpr bool operator==(ExactQty<U, R1> q1, ExactQty<U, R2> q2) {
+      using CommonQty = details::common_exact_qty<U, R1, R2>;
+      const CommonQty val1 = qtyCast<CommonQty>(q1).normalized();
+      const CommonQty val2 = qtyCast<CommonQty>(q2).normalized();
+      return val1.num == val2.num && val1.den == val2.den;
+  }
+
+  template<typename U, typename R1, typename R2>
+  constexpr std::strong_ordering operator<=>(ExactQty<U, R1> q1, ExactQty<U, R2> q2) {
+      using CommonQty = details::common_exact_qty<U, R1, R2>;
+      const CommonQty val1 = qtyCast<CommonQty>(q1).normalized();
+      const CommonQty val2 = qtyCast<CommonQty>(q2).normalized();
+      return details::wide_int(val1.num) * val2.den <=> details::wide_int(val2.num) * val1.den;
+  }
+
+  /*
+   * Arithmetic operators, none of them divides
+   */
+
+  template<typename U, typename R1, typename R2>
+  constexpr auto operator+(ExactQty<U, R1> q1, ExactQty<U, R2> q2) {
+      using CommonQty = details::common_exact_qty<U, R1, R2>;
+      const CommonQty val1 = qtyCast<CommonQty>(q1);
+      const CommonQty val2 = qtyCast<CommonQty>(q2);
+      const details::Fraction res = details::exactSum(val1.num, val1.den, val2.num, val2.den);
+      return CommonQty(res.num, res.den);
+  }
+
+  template<typename U, typename R1, typename R2>
+  constexpr auto operator-(ExactQty<U, R1> q1, ExactQty<U, R2> q2) {
+      return q1 + ExactQty<U, R2>(-q2.num, q2.den);
+  }
+
+  template<typename U1, typename R1, typename U2, typename R2>
+  constexpr auto operator*(ExactQty<U1, R1> q1, ExactQty<U2, R2> q2) {
+      using unitRes = typename PackedUnit<U1::dims + U2::dims>::type;
+      using ratioRes = std::ratio_multiply<R1, R2>;
+
+      const details::Fraction res = details::exactProduct(q1.num, q1.den, q2.num, q2.den);
+      return ExactQty<unitRes, ratioRes>(res.num, res.den);
+  }
+
+  template<typename U1, typename R1, typename U2, typename R2>
+  constexpr auto operator/(ExactQty<U1, R1> q1, ExactQty<U2, R2> q2) {
+      using unitRes = typename PackedUnit<U1::dims - U2::dims>::type;
+      using ratioRes = std::ratio_divide<R1, R2>;
+
+      const details::Fraction res = details::exactProduct(q1.num, q1.den, q2.den, q2.num);
+      return ExactQty<unitRes, ratioRes>(res.num, res.den);
+  }
+
+}
+
+#endif // UNITS_EXACT_H
@@ -0,0 +1,301 @@
+#ifndef UNITS_EXPRESSION_H
+#define UNITS_EXPRESSION_H
+
+#include "Units.h"
+
+#include <cstddef>
+#include <numeric>
+
+namespace phy {
+
+  namespace details {
+
+    /*
+     * A string usable as a template argument
+     */
+
+    template<std::size_t N>
+    struct FixedString {
+      char chars[N] = {};
+
+      constexpr FixedString(const char (&str)[N]) {
+          for (std::size_t i = 0; i < N; ++i) {
+              chars[i] = str[i];
+          }
+      }
+
+      static constexpr std::size_t size = N - 1;
+    };
+
+    // Not constexpr on purpose: reaching it while parsing turns into a compile error pointing here
+    inline void invalid_unit_expression(const char*) {}
+
+    /*
+     * Exponents of the base units along with the ratio to them
+     */
+
+    struct ParsedUnit {
+      int exponents[7] = {};
+      intmax_t num = 1;
+      intmax_t den = 1;
+
+      constexpr void reduce() {
+          const intmax_t g = std::gcd(num, den);
+          num /= g;
+          den /= g;
+      }
+
+      constexpr ParsedUnit& operator*=(const ParsedUnit& other) {
+          for (int i = 0; i < 7; ++i) {
+              exponents[i] += other.exponents[i];
+          }
+          // Cross reduction first to keep the products small
+          const intmax_t g1 = std::gcd(num, other.den);
+          const intmax_t g2 = std::gcd(other.num, den);
+          num = (num / g1) * (other.num / g2);
+          den = (den / g2) * (other.den / g1);
+          return *this;
+      }
+
+      constexpr ParsedUnit inverse() const {
+          ParsedUnit res;
+          for (int i = 0; i < 7; ++i) {
+              res.exponents[i] = -exponents[i];
+          }
+          res.num = den;
+          res.den = num;
+          return res;
+      }
+
+      constexpr ParsedUnit pow(int n) const {
+          const ParsedUnit base = n < 0 ? inverse() : *this;
+          ParsedUnit res;
+          for (int i = 0; i < (n < 0 ? -n : n); ++i) {
+              res *= base;
+          }
+          return res;
+      }
+    };
+
+    struct UnitSymbol {
+      const char* name;
+      ParsedUnit unit;
+    };
+
+    //                                                m   kg   s   A   K  mol cd
+    inline constexpr UnitSymbol unit_symbols[] = {
+      { "m",    { { 1,  0,  0,  0,  0,  0,  0 }, 1, 1 } },
+      { "g",    { { 0,  1,  0,  0,  0,  0,  0 }, 1, 1000 } },
+      { "s",    { { 0,  0,  1,  0,  0,  0,  0 }, 1, 1 } },
+      { "A",    { { 0,  0,  0,  1,  0,  0,  0 }, 1, 1 } },
+      { "K",    { { 0,  0,  0,  0,  1,  0,  0 }, 1, 1 } },
+      { "mol",  { { 0,  0,  0,  0,  0,  1,  0 }, 1, 1 } },
+      { "cd",   { { 0,  0,  0,  0,  0,  0,  1 }, 1, 1 } },
+      { "rad",  { { 0,  0,  0,  0,  0,  0,  0 }, 1, 1 } },
+      { "min",  { { 0,  0,  1,  0,  0,  0,  0 }, 60, 1 } },
+      { "h",    { { 0,  0,  1,  0,  0,  0,  0 }, 3600, 1 } },
+      { "Hz",   { { 0,  0, -1,  0,  0,  0,  0 }, 1, 1 } },
+      { "N",    { { 1,  1, -2,  0,  0,  0,  0 }, 1, 1 } },
+      { "Pa",   { {-1,  1, -2,  0,  0,  0,  0 }, 1, 1 } },
+      { "J",    { { 2,  1, -2,  0,  0,  0,  0 }, 1, 1 } },
+      { "W",    { { 2,  1, -3,  0,  0,  0,  0 }, 1, 1 } },
+      { "C",    { { 0,  0,  1,  1,  0,  0,  0 }, 1, 1 } },
+      { "V",    { { 2,  1, -3, -1,  0,  0,  0 }, 1, 1 } },
+      { "Ohm",  { { 2,  1, -3, -2,  0,  0,  0 }, 1, 1 } },
+    };
+
+    // Longest prefixes first so that "da" is tried before "d"
+    inline constexpr UnitSymbol unit_prefixes[] = {
+      { "da",   { {}, 10, 1 } },
+      { "E",    { {}, 1000000000000000000, 1 } },
+      { "P",    { {}, 1000000000000000, 1 } },
+      { "T",    { {}, 1000000000000, 1 } },
+      { "G",    { {}, 1000000000, 1 } },
+      { "M",    { {}, 1000000, 1 } },
+      { "k",    { {}, 1000, 1 } },
+      { "h",    { {}, 100, 1 } },
+      { "d",    { {}, 1, 10 } },
+      { "c",    { {}, 1, 100 } },
+      { "m",    { {}, 1, 1000 } },
+      { "u",    { {}, 1, 1000000 } },
+      { "n",    { {}, 1, 1000000000 } },
+      { "p",    { {}, 1, 1000000000000 } },
+      { "f",    { {}, 1, 1000000000000000 } },
+      { "a",    { {}, 1, 1000000000000000000 } },
+    };
+
+    /*
+     * Recursive descent parser for expressions like "kg*m/s^2" or "km/(h.s)"
+     *
+     * expr    := factor (('*' | '.' | '/') factor)*
+     * factor  := primary ('^' '-'? digits)?
+     * primary := '1' | symbol | '(' expr ')'
+     */
+
+    class UnitParser {
+    public:
+      constexpr UnitParser(const char* str, std::size_t size) : str(str), size(size), pos(0) {}
+
+      constexpr ParsedUnit parse() {
+          ParsedUnit res = parseExpr();
+          skipSpaces();
+          if (pos != size) {
+              invalid_unit_expression("unexpected character in unit expression");
+          }
+          res.reduce();
+          return res;
+      }
+
+    private:
+      constexpr void skipSpaces() {
+          while (pos < size && str[pos] == ' ') {
+              ++pos;
+          }
+      }
+
+      constexpr ParsedUnit parseExpr() {
+          ParsedUnit res = parseFactor();
+          for (;;) {
+              skipSpaces();
+              if (pos < size && (str[pos] == '*' || str[pos] == '.')) {
+                  ++pos;
+                  res *= parseFactor();
+              } else if (pos < size && str[pos] == '/') {
+                  ++pos;
+                  res *= parseFactor().inverse();
+              } else {
+                  return res;
+              }
+          }
+      }
+
+      constexpr ParsedUnit parseFactor() {
+          const ParsedUnit base = parsePrimary();
+          skipSpaces();
+          if (pos == size || str[pos] != '^') {
+              return base;
+          }
+          ++pos;
+          bool negative = false;
+          if (pos < size && str[pos] == '-') {
+              negative = true;
+              ++pos;
+          }
+          if (pos == size || str[pos] < '0' || str[pos] > '9') {
+              invalid_unit_expression("missing exponent after '^'");
+          }
+          int exponent = 0;
+          while (pos < size && str[pos] >= '0' && str[pos] <= '9') {
+              exponent = exponent * 10 + (str[pos] - '0');
+              ++pos;
+          }
+          return base.pow(negative ? -exponent : exponent);
+      }
+
+      constexpr ParsedUnit parsePrimary() {
+          skipSpaces();
+          if (pos < size && str[pos] == '(') {
+              ++pos;
+              const ParsedUnit res = parseExpr();
+              skipSpaces();
+              if (pos == size || str[pos] != ')') {
+                  invalid_unit_expression("missing ')' in unit expression");
+              }
+              ++pos;
+              return res;
+          }
+          if (pos < size && str[pos] == '1') {
+              ++pos;
+              return ParsedUnit();
+          }
+
+          const std::size_t start = pos;
+          while (pos < size && isLetter(str[pos])) {
+              ++pos;
+          }
+          if (start == pos) {
+              invalid_unit_expression("expected a unit symbol");
+          }
+          return parseSymbol(start, pos);
+      }
+
+      // A whole symbol wins over a prefixed one, so "min" is minutes and "cd" candelas
+      constexpr ParsedUnit parseSymbol(std::size_t start, std::size_t end) const {
+          for (const UnitSymbol& symbol : unit_symbols) {
+              if (matches(symbol.name, start, end)) {
+                  return symbol.unit;
+              }
+          }
+          for (const UnitSymbol& prefix : unit_prefixes) {
+              const std::size_t prefixEnd = start + length(prefix.name);
+              if (prefixEnd >= end || !matches(prefix.name, start, prefixEnd)) {
+                  continue;
+              }
+              for (const UnitSymbol& symbol : unit_symbols) {
+                  if (matches(symbol.name, prefixEnd, end)) {
+                      ParsedUnit res = prefix.unit;
+                      res *= symbol.unit;
+                      return res;
+                  }
+              }
+          }
+          invalid_unit_expression("unknown unit symbol");
+          return ParsedUnit();
+      }
+
+      static constexpr bool isLetter(char c) {
+          return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+      }
+
+      static constexpr std::size_t length(const char* name) {
+          std::size_t res = 0;
+          while (name[res] != '\0') {
+              ++res;
+          }
+          return res;
+      }
+
+      constexpr bool matches(const char* name, std::size_t start, std::size_t end) const {
+          if (length(name) != end - start) {
+              return false;
+          }
+          for (std::size_t i = start; i < end; ++i) {
+              if (str[i] != name[i - start]) {
+                  return false;
+              }
+          }
+          return true;
+      }
+
+      const char* str;
+      std::size_t size;
+      std::size_t pos;
+    };
+
+    template<FixedString S>
+    struct parsed_unit {
+        static constexpr ParsedUnit value = UnitParser(S.chars, S.size).parse();
+
+        using unit = Unit<value.exponents[0], value.exponents[1], value.exponents[2], value.exponents[3],
+          value.exponents[4], value.exponents[5], value.exponents[6]>;
+        using ratio = std::ratio<value.num, value.den>;
+    };
+
+  }
+
+  /*
+   * Units and quantities spelled as strings, parsed at compile time
+   */
+
+  // Equivalent spellings give the very same types: unit<"N"> is unit<"kg*m/s^2"> is Newton
+
+  template<details::FixedString S>
+  using unit = typename details::parsed_unit<S>::unit;
+
+  // The prefixes and non-SI units go in the ratio: qtyOf<"km/h"> is Qty<Speed, std::ratio<5, 18>>
+  template<details::FixedString S>
+  using qtyOf = Qty<typename details::parsed_unit<S>::unit, typename details::parsed_unit<S>::ratio>;
+
+}
+
+#endif // UNITS_EXPRESSION_H
@@ -0,0 +1,452 @@
+#ifndef UNITS_FORMULA_H
+#define UNITS_FORMULA_H
+
+#include "Units.h"
+
+#include <cstddef>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace phy {
+
+  /*
+   * Error raised when a formula does not parse or mixes incompatible units
+   */
+  class FormulaError : public std::runtime_error {
+  public:
+    using std::runtime_error::runtime_error;
+  };
+
+  namespace details {
+
+    /*
+     * Ratio known only at runtime, always reduced
+     */
+
+    struct RuntimeRatio {
+      intmax_t num = 1;
+      intmax_t den = 1;
+
+      bool operator==(const RuntimeRatio&) const = default;
+    };
+
+    inline RuntimeRatio makeRatio(intmax_t num, intmax_t den) {
+        const intmax_t g = std::gcd(num, den);
+        return { num / g, den / g };
+    }
+
+    inline RuntimeRatio multiply(RuntimeRatio r1, RuntimeRatio r2) {
+        const intmax_t g1 = std::gcd(r1.num, r2.den);
+        const intmax_t g2 = std::gcd(r2.num, r1.den);
+        return { (r1.num / g1) * (r2.num / g2), (r1.den / g2) * (r2.den / g1) };
+    }
+
+    inline RuntimeRatio divide(RuntimeRatio r1, RuntimeRatio r2) {
+        return multiply(r1, { r2.den, r2.num });
+    }
+
+    // Same as common_ratio, every value of both ratios is a whole multiple of it
+    inline RuntimeRatio commonRatio(RuntimeRatio r1, RuntimeRatio r2) {
+        return makeRatio(std::gcd(r1.num, r2.num), std::lcm(r1.den, r2.den));
+    }
+
+    /*
+     * Register bytecode, each instruction runs over a whole batch
+     */
+
+    enum class FormulaOp {
+      Fill,   // dst = num
+      Add,    // dst = a + b
+      Sub,    // dst = a - b
+      Mul,    // dst = a * b
+      Div,    // dst = a / b
+      Scale,  // dst = a * num / den
+    };
+
+    struct FormulaInstruction {
+      FormulaOp op;
+      std::size_t dst;
+      std::size_t a;
+      std::size_t b;
+      intmax_t num;
+      intmax_t den;
+    };
+
+  }
+
+  /*
+   * A formula compiled for a set of channels
+   */
+
+  class Formula {
+  public:
+    // Name of the channel the formula computes
+    const std::string& target() const {
+        return targetName;
+    }
+
+    // Names of the channels read, in the order expected by evaluate()
+    const std::vector<std::string>& inputs() const {
+        return inputNames;
+    }
+
+    // Values of the inputs are given in the ratio of their channel, the result is in the ratio of the target
+    void evaluate(std::span<const std::span<const intmax_t>> columns, std::span<intmax_t> out) const {
+        if (columns.size() != inputNames.size()) {
+            throw FormulaError("formula for '" + targetName + "' expects " + std::to_string(inputNames.size()) + " columns");
+        }
+        const std::size_t n = out.size();
+        for (std::span<const intmax_t> column : columns) {
+            if (column.size() < n) {
+                throw FormulaError("formula for '" + targetName + "' has an input column shorter than the output");
+            }
+        }
+
+        std::vector<intmax_t> scratch(registers * n);
+        std::vector<intmax_t*> slots(inputNames.size() + registers + 1);
+        for (std::size_t r = 0; r < registers; ++r) {
+            slots[inputNames.size() + r] = scratch.data() + r * n;
+        }
+        slots.back() = out.data();
+
+        auto source = [&](std::size_t slot) -> const intmax_t* {
+            return slot < inputNames.size() ? columns[slot].data() : slots[slot];
+        };
+
+        // One dispatch per instruction and per batch, the loops themselves are plain
+        for (const details::FormulaInstruction& ins : code) {
+            intmax_t* dst = slots[ins.dst];
+            const intmax_t* a = ins.op == details::FormulaOp::Fill ? nullptr : source(ins.a);
+            const intmax_t* b = ins.op == details::FormulaOp::Fill || ins.op == details::FormulaOp::Scale ? nullptr : source(ins.b);
+
+            switch (ins.op) {
+            case details::FormulaOp::Fill:
+                for (std::size_t i = 0; i < n; ++i) dst[i] = ins.num;
+                break;
+            case details::FormulaOp::Add:
+                for (std::size_t i = 0; i < n; ++i) dst[i] = a[i] + b[i];
+                break;
+            case details::FormulaOp::Sub:
+                for (std::size_t i = 0; i < n; ++i) dst[i] = a[i] - b[i];
+                break;
+            case details::FormulaOp::Mul:
+                for (std::size_t i = 0; i < n; ++i) dst[i] = a[i] * b[i];
+                break;
+            case details::FormulaOp::Div:
+                for (std::size_t i = 0; i < n; ++i) dst[i] = a[i] / b[i];
+                break;
+            case details::FormulaOp::Scale:
+                for (std::size_t i = 0; i < n; ++i) dst[i] = a[i] * ins.num / ins.den;
+                break;
+            }
+        }
+    }
+
+    // Same as above, the columns are looked up by channel name
+    void evaluate(const std::unordered_map<std::string, std::span<const intmax_t>>& columns, std::span<intmax_t> out) const {
+        std::vector<std::span<const intmax_t>> ordered;
+        for (const std::string& name : inputNames) {
+            const auto it = columns.find(name);
+            if (it == columns.end()) {
+                throw FormulaError("missing column '" + name + "'");
+            }
+            ordered.push_back(it->second);
+        }
+        evaluate(std::span<const std::span<const intmax_t>>(ordered), out);
+    }
+
+    const std::vector<details::FormulaInstruction>& bytecode() const {
+        return code;
+    }
+
+  private:
+    friend class FormulaCompiler;
+
+    std::string targetName;
+    std::vector<std::string> inputNames;
+    std::size_t registers = 0;
+    std::vector<details::FormulaInstruction> code;
+  };
+
+  /*
+   * Channels declared with the unit and ratio of a quantity
+   */
+
+  struct FormulaChannel {
+    intmax_t dims;
+    details::RuntimeRatio ratio;
+  };
+
+  /*
+   * Recursive descent compiler from source to bytecode
+   *
+   * formula := name '=' expr
+   * expr    := term (('+' | '-') term)*
+   * term    := primary (('*' | '/') primary)*
+   * primary := integer | name | '(' expr ')'
+   */
+
+  class FormulaCompiler {
+  public:
+    FormulaCompiler(std::string_view source, const std::unordered_map<std::string, FormulaChannel>& channels)
+    : source(source), channels(channels), pos(0) {}
+
+    Formula compile() {
+        skipSpaces();
+        formula.targetName = parseName();
+        const auto target = channels.find(formula.targetName);
+        if (target == channels.end()) {
+            fail("unknown channel '" + formula.targetName + "'");
+        }
+        expect('=');
+
+        const Value res = parseExpr();
+        skipSpaces();
+        if (pos != source.size()) {
+            fail("unexpected character");
+        }
+        if (res.dims != target->second.dims) {
+            fail("the expression does not have the unit of '" + formula.targetName + "'");
+        }
+
+        // The whole ratio of the expression is applied once, at the very end
+        const details::RuntimeRatio conv = details::divide(res.ratio, target->second.ratio);
+        const std::size_t out = formula.inputNames.size() + formula.registers;
+        if (res.constant) {
+            emit({ details::FormulaOp::Fill, out, 0, 0, res.value * conv.num / conv.den, 1 });
+        } else if (conv == details::RuntimeRatio() && !formula.code.empty() && formula.code.back().dst == res.slot) {
+            formula.code.back().dst = out;
+        } else {
+            emit({ details::FormulaOp::Scale, out, res.slot, 0, conv.num, conv.den });
+        }
+
+        // Registers are numbered after the inputs, which are only known now
+        for (details::FormulaInstruction& ins : formula.code) {
+            relocate(ins.dst);
+            relocate(ins.a);
+            relocate(ins.b);
+        }
+        return formula;
+    }
+
+  private:
+    // Either a constant folded at compile time or a slot holding a column of values
+    struct Value {
+      bool constant;
+      intmax_t value;
+      std::size_t slot;
+      intmax_t dims;
+      details::RuntimeRatio ratio;
+    };
+
+    // Until relocation, slots are tagged: inputs as is, registers offset by this
+    static constexpr std::size_t register_tag = std::size_t(1) << 40;
+
+    [[noreturn]] void fail(const std::string& message) const {
+        throw FormulaError(message + " at position " + std::to_string(pos) + " in '" + std::string(source) + "'");
+    }
+
+    void relocate(std::size_t& slot) const {
+        if (slot >= register_tag) {
+            slot = slot - register_tag + formula.inputNames.size();
+        }
+    }
+
+    void skipSpaces() {
+        while (pos < source.size() && source[pos] == ' ') {
+            ++pos;
+        }
+    }
+
+    void expect(char c) {
+        skipSpaces();
+        if (pos == source.size() || source[pos] != c) {
+            fail(std::string("expected '") + c + "'");
+        }
+        ++pos;
+    }
+
+    static bool isNameChar(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    }
+
+    std::string parseName() {
+        const std::size_t start = pos;
+        while (pos < source.size() && isNameChar(source[pos])) {
+            ++pos;
+        }
+        if (start == pos) {
+            fail("expected a channel name");
+        }
+        return std::string(source.substr(start, pos - start));
+    }
+
+    void emit(details::FormulaInstruction ins) {
+        formula.code.push_back(ins);
+    }
+
+    std::size_t newRegister() {
+        return register_tag + formula.registers++;
+    }
+
+    // Turns a constant into a column when it has to meet one
+    std::size_t materialize(const Value& v) {
+        if (!v.constant) {
+            return v.slot;
+        }
+        const std::size_t dst = newRegister();
+        emit({ details::FormulaOp::Fill, dst, 0, 0, v.value, 1 });
+        return dst;
+    }
+
+    Value column(std::size_t slot, intmax_t dims, details::RuntimeRatio ratio) {
+        return { false, 0, slot, dims, ratio };
+    }
+
+    // Multiplication by an integer factor, folded for constants
+    Value rescale(const Value& v, intmax_t factor, details::RuntimeRatio ratio) {
+        if (v.constant) {
+            return { true, v.value * factor, 0, v.dims, ratio };
+        }
+        if (factor == 1) {
+            return column(v.slot, v.dims, ratio);
+        }
+        const std::size_t dst = newRegister();
+        emit({ details::FormulaOp::Scale, dst, v.slot, 0, factor, 1 });
+        return column(dst, v.dims, ratio);
+    }
+
+    Value parseExpr() {
+        Value res = parseTerm();
+        for (;;) {
+            skipSpaces();
+            if (pos == source.size() || (source[pos] != '+' && source[pos] != '-')) {
+                return res;
+            }
+            const bool plus = source[pos++] == '+';
+            Value rhs = parseTerm();
+
+            if (res.dims != rhs.dims) {
+                fail(std::string("operands of '") + (plus ? '+' : '-') + "' have different units");
+            }
+
+            // Both sides go to their exact common ratio, which only needs a multiplication
+            const details::RuntimeRatio common = details::commonRatio(res.ratio, rhs.ratio);
+            res = rescale(res, details::divide(res.ratio, common).num, common);
+            rhs = rescale(rhs, details::divide(rhs.ratio, common).num, common);
+
+            if (res.constant && rhs.constant) {
+                res.value = plus ? res.value + rhs.value : res.value - rhs.value;
+                continue;
+            }
+            const std::size_t dst = newRegister();
+            emit({ plus ? details::FormulaOp::Add : details::FormulaOp::Sub, dst, materialize(res), materialize(rhs), 0, 0 });
+            res = column(dst, res.dims, common);
+        }
+    }
+
+    Value parseTerm() {
+        Value res = parsePrimary();
+        for (;;) {
+            skipSpaces();
+            if (pos == source.size() || (source[pos] != '*' && source[pos] != '/')) {
+                return res;
+            }
+            const bool times = source[pos++] == '*';
+            const Value rhs = parsePrimary();
+
+            // Same exponent arithmetic as operator* and operator/, the ratios are only carried along
+            const intmax_t dims = times ? res.dims + rhs.dims : res.dims - rhs.dims;
+            const details::RuntimeRatio ratio = times ? details::multiply(res.ratio, rhs.ratio) : details::divide(res.ratio, rhs.ratio);
+
+            if (!times && rhs.constant && rhs.value == 0) {
+                fail("division by zero");
+            }
+
+            if (res.constant && rhs.constant) {
+                res = { true, times ? res.value * rhs.value : res.value / rhs.value, 0, dims, ratio };
+            } else if (rhs.constant) {
+                const std::size_t dst = newRegister();
+                emit({ details::FormulaOp::Scale, dst, res.slot, 0, times ? rhs.value : 1, times ? 1 : rhs.value });
+                res = column(dst, dims, ratio);
+            } else if (res.constant && times) {
+                const std::size_t dst = newRegister();
+                emit({ details::FormulaOp::Scale, dst, rhs.slot, 0, res.value, 1 });
+                res = column(dst, dims, ratio);
+            } else {
+                const std::size_t dst = newRegister();
+                emit({ times ? details::FormulaOp::Mul : details::FormulaOp::Div, dst, materialize(res), rhs.slot, 0, 0 });
+                res = column(dst, dims, ratio);
+            }
+        }
+    }
+
+    Value parsePrimary() {
+        skipSpaces();
+        if (pos < source.size() && source[pos] == '(') {
+            ++pos;
+            const Value res = parseExpr();
+            expect(')');
+            return res;
+        }
+        if (pos < source.size() && source[pos] >= '0' && source[pos] <= '9') {
+            intmax_t value = 0;
+            while (pos < source.size() && source[pos] >= '0' && source[pos] <= '9') {
+                value = value * 10 + (source[pos] - '0');
+                ++pos;
+            }
+            return { true, value, 0, 0, details::RuntimeRatio() };
+        }
+
+        const std::string name = parseName();
+        const auto channel = channels.find(name);
+        if (channel == channels.end()) {
+            fail("unknown channel '" + name + "'");
+        }
+
+        // Each channel is read from its input column, once per batch whatever its number of uses
+        std::size_t slot = 0;
+        while (slot < formula.inputNames.size() && formula.inputNames[slot] != name) {
+            ++slot;
+        }
+        if (slot == formula.inputNames.size()) {
+            formula.inputNames.push_back(name);
+        }
+        return column(slot, channel->second.dims, channel->second.ratio);
+    }
+
+    std::string_view source;
+    const std::unordered_map<std::string, FormulaChannel>& channels;
+    std::size_t pos;
+    Formula formula;
+  };
+
+  /*
+   * Set of named channels and the formulas over them
+   */
+
+  class FormulaEngine {
+  public:
+    // Declares a channel whose values are in the unit and ratio of Q
+    template<typename Q>
+    void declare(const std::string& name) {
+        channels[name] = { Q::Unit::dims, details::makeRatio(Q::Ratio::num, Q::Ratio::den) };
+    }
+
+    // Compiles a formula such as "power = voltage * current", throws FormulaError when it is invalid
+    Formula compile(std::string_view source) const {
+        return FormulaCompiler(source, channels).compile();
+    }
+
+  private:
+    std::unordered_map<std::string, FormulaChannel> channels;
+  };
+
+}
+
+#endif // UNITS_FORMULA_H
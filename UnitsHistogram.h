@@ -0,0 +1,201 @@
+#ifndef UNITS_HISTOGRAM_H
+#define UNITS_HISTOGRAM_H
+
+#include "Units.h"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace phy {
+
+  namespace details {
+
+    // Sample-to-width conversion folded into one multiplier and one divisor known at compile time
+    template<typename SampleQty, auto Width>
+    struct bin_scale {
+        using WidthQty = decltype(Width);
+        static_assert(std::is_same_v<typename SampleQty::Unit, typename WidthQty::Unit>,
+          "histogram bins require the unit of the samples");
+        static_assert(Width.value > 0, "histogram bins require a positive width");
+
+        using Conv = std::ratio_divide<typename SampleQty::Ratio, typename WidthQty::Ratio>;
+
+        static constexpr intmax_t num = Conv::num;
+        static constexpr intmax_t den = Conv::den * Width.value;
+
+        // Larger samples would overflow once multiplied, they belong to the last bin anyway
+        static constexpr intmax_t max_sample = INTMAX_MAX / num;
+    };
+
+  }
+
+  /*
+   * Binning strategies, they map a sample to a bin and a bin to its lower bound
+   */
+
+  // Bins of constant width, samples outside of the range fall in the first or last bin
+  template<typename SampleQty, auto Width, std::size_t Bins>
+  struct FixedBins {
+    using Sample = SampleQty;
+    using Bound = decltype(Width);
+
+    static constexpr std::size_t size = Bins;
+
+    // Both constants are known at compile time, the division is emitted as a multiply and a shift
+    static std::size_t index(SampleQty sample) {
+        using scale = details::bin_scale<SampleQty, Width>;
+        if (sample.value < 0) {
+            return 0;
+        }
+        if (sample.value > scale::max_sample) {
+            return Bins - 1;
+        }
+        const intmax_t bin = sample.value * scale::num / scale::den;
+        return bin < intmax_t(Bins) ? std::size_t(bin) : Bins - 1;
+    }
+
+    static Bound lowerBound(std::size_t bin) {
+        return Bound(intmax_t(bin) * Width.value);
+    }
+  };
+
+  // Bins that double in width every 2^SubBits bins (HDR style), precise to one Resolution
+  template<typename SampleQty, auto Resolution, int SubBits = 5>
+  struct LogLinearBins {
+    using Sample = SampleQty;
+    using Bound = decltype(Resolution);
+
+    static_assert(SubBits > 0 && SubBits < 16, "log-linear bins require between 1 and 15 sub-bucket bits");
+
+    static constexpr std::size_t subBuckets = std::size_t(1) << SubBits;
+    static constexpr std::size_t size = (64 - SubBits) * subBuckets;
+
+    // Negative samples fall in the first bin
+    static std::size_t index(SampleQty sample) {
+        using scale = details::bin_scale<SampleQty, Resolution>;
+        if (sample.value < 0) {
+            return 0;
+        }
+        if (sample.value > scale::max_sample) {
+            return size - 1;
+        }
+        const uintmax_t v = uintmax_t(sample.value * scale::num / scale::den);
+        if (v < subBuckets) {
+            return std::size_t(v);
+        }
+        const int shift = std::bit_width(v) - 1 - SubBits;
+        return std::size_t(shift) * subBuckets + std::size_t(v >> shift);
+    }
+
+    static Bound lowerBound(std::size_t bin) {
+        if (bin < subBuckets) {
+            return Bound(intmax_t(bin) * Resolution.value);
+        }
+        const std::size_t shift = bin / subBuckets - 1;
+        const intmax_t sub = intmax_t(bin % subBuckets + subBuckets);
+        return Bound((sub << shift) * Resolution.value);
+    }
+  };
+
+  /*
+   * A histogram counting samples in the bins of a strategy
+   */
+
+  template<typename BinsT>
+  class Histogram {
+  public:
+    using Bins = BinsT;
+    using Sample = typename Bins::Sample;
+
+    void record(Sample sample) {
+        ++counts[Bins::index(sample)];
+    }
+
+    void add(std::size_t bin, uint64_t count) {
+        counts[bin] += count;
+    }
+
+    uint64_t count(std::size_t bin) const {
+        return counts[bin];
+    }
+
+    uint64_t total() const {
+        uint64_t res = 0;
+        for (uint64_t c : counts) {
+            res += c;
+        }
+        return res;
+    }
+
+    static constexpr std::size_t size() {
+        return Bins::size;
+    }
+
+    static typename Bins::Bound lowerBound(std::size_t bin) {
+        return Bins::lowerBound(bin);
+    }
+
+    Histogram& operator+=(const Histogram& other) {
+        for (std::size_t i = 0; i < Bins::size; ++i) {
+            counts[i] += other.counts[i];
+        }
+        return *this;
+    }
+
+  private:
+    std::array<uint64_t, Bins::size> counts = {};
+  };
+
+  template<typename SampleQty, auto Width, std::size_t Bins>
+  using FixedHistogram = Histogram<FixedBins<SampleQty, Width, Bins>>;
+
+  template<typename SampleQty, auto Resolution, int SubBits = 5>
+  using LogLinearHistogram = Histogram<LogLinearBins<SampleQty, Resolution, SubBits>>;
+
+  /*
+   * A histogram recorded from many threads at once
+   */
+
+  // Each thread writes in its own shard so the counters do not bounce between caches
+  template<typename BinsT, std::size_t Shards = 16>
+  class ShardedHistogram {
+  public:
+    using Bins = BinsT;
+    using Sample = typename Bins::Sample;
+
+    void record(Sample sample) {
+        shards[shardIndex()].counts[Bins::index(sample)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Counts recorded while the snapshot is taken may or may not be included
+    Histogram<Bins> snapshot() const {
+        Histogram<Bins> res;
+        for (const Shard& shard : shards) {
+            for (std::size_t i = 0; i < Bins::size; ++i) {
+                res.add(i, shard.counts[i].load(std::memory_order_relaxed));
+            }
+        }
+        return res;
+    }
+
+  private:
+    struct alignas(64) Shard {
+      std::array<std::atomic<uint64_t>, Bins::size> counts = {};
+    };
+
+    static std::size_t shardIndex() {
+        static std::atomic<std::size_t> next = 0;
+        thread_local const std::size_t index = next.fetch_add(1, std::memory_order_relaxed) % Shards;
+        return index;
+    }
+
+    std::array<Shard, Shards> shards;
+  };
+
+}
+
+#endif // UNITS_HISTOGRAM_H
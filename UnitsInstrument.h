@@ -0,0 +1,188 @@
+#ifndef UNITS_INSTRUMENT_H
+#define UNITS_INSTRUMENT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <ratio>
+#include <vector>
+
+/*
+ * Counters of the conversions between ratios, compiled in with UNITS_INSTRUMENT
+ *
+ * Without the macro this header is not even included by Units.h and conversions
+ * are the plain `value * num / den` they always were.
+ */
+
+namespace phy {
+
+  /*
+   * Counts for one (from, to) pair of ratios
+   */
+
+  struct CastStats {
+    intmax_t fromNum;
+    intmax_t fromDen;
+    intmax_t toNum;
+    intmax_t toDen;
+
+    uint64_t conversions = 0;
+    uint64_t truncations = 0;   // the division dropped a non-zero remainder
+    uint64_t overflows = 0;     // the multiplication by the numerator overflowed
+  };
+
+  namespace details {
+
+    struct CastCounters {
+      std::atomic<uint64_t> conversions;
+      std::atomic<uint64_t> truncations;
+      std::atomic<uint64_t> overflows;
+    };
+
+    // Only the owning thread writes its counters, a relaxed load and store is enough
+    inline void bump(std::atomic<uint64_t>& counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    /*
+     * Known pairs of ratios and the counters of every live thread
+     */
+
+    class CastRegistry {
+    public:
+      static CastRegistry& instance() {
+          static CastRegistry registry;
+          return registry;
+      }
+
+      std::size_t addSite(intmax_t fromNum, intmax_t fromDen, intmax_t toNum, intmax_t toDen) {
+          std::lock_guard<std::mutex> lock(mutex);
+          sites.push_back({ fromNum, fromDen, toNum, toDen });
+          return sites.size() - 1;
+      }
+
+      void attach(std::deque<CastCounters>* counters) {
+          std::lock_guard<std::mutex> lock(mutex);
+          threads.push_back(counters);
+      }
+
+      // The counts of a finished thread are kept in the sites themselves
+      void detach(std::deque<CastCounters>* counters) {
+          std::lock_guard<std::mutex> lock(mutex);
+          addCounts(sites, *counters);
+          std::erase(threads, counters);
+      }
+
+      // Growing takes the lock so that a concurrent snapshot never sees a deque being resized
+      void grow(std::deque<CastCounters>& counters, std::size_t size) {
+          std::lock_guard<std::mutex> lock(mutex);
+          while (counters.size() < size) {
+              counters.emplace_back();
+          }
+      }
+
+      std::vector<CastStats> snapshot() {
+          std::lock_guard<std::mutex> lock(mutex);
+          std::vector<CastStats> res = sites;
+          for (const std::deque<CastCounters>* counters : threads) {
+              addCounts(res, *counters);
+          }
+          return res;
+      }
+
+      // Counts of other threads converting meanwhile may survive the reset
+      void reset() {
+          std::lock_guard<std::mutex> lock(mutex);
+          for (CastStats& site : sites) {
+              site.conversions = site.truncations = site.overflows = 0;
+          }
+          for (std::deque<CastCounters>* counters : threads) {
+              for (CastCounters& c : *counters) {
+                  c.conversions.store(0, std::memory_order_relaxed);
+                  c.truncations.store(0, std::memory_order_relaxed);
+                  c.overflows.store(0, std::memory_order_relaxed);
+              }
+          }
+      }
+
+    private:
+      CastRegistry() = default;
+
+      static void addCounts(std::vector<CastStats>& stats, const std::deque<CastCounters>& counters) {
+          for (std::size_t i = 0; i < counters.size(); ++i) {
+              stats[i].conversions += counters[i].conversions.load(std::memory_order_relaxed);
+              stats[i].truncations += counters[i].truncations.load(std::memory_order_relaxed);
+              stats[i].overflows += counters[i].overflows.load(std::memory_order_relaxed);
+          }
+      }
+
+      std::mutex mutex;
+      std::vector<CastStats> sites;
+      std::vector<std::deque<CastCounters>*> threads;
+    };
+
+    struct ThreadCastCounters {
+      std::deque<CastCounters> counters;
+
+      ThreadCastCounters() {
+          CastRegistry::instance().attach(&counters);
+      }
+
+      ~ThreadCastCounters() {
+          CastRegistry::instance().detach(&counters);
+      }
+    };
+
+    inline thread_local ThreadCastCounters thread_cast_counters;
+
+    template<typename From, typename To>
+    std::size_t castSite() {
+        static const std::size_t site = CastRegistry::instance().addSite(From::num, From::den, To::num, To::den);
+        return site;
+    }
+
+    /*
+     * Conversion counting what happens, the overflowing product wraps instead of being undefined
+     */
+
+    template<typename From, typename To>
+    intmax_t instrumentedConvert(intmax_t value) {
+        using Conv = std::ratio_divide<From, To>;
+
+        std::deque<CastCounters>& counters = thread_cast_counters.counters;
+        const std::size_t site = castSite<From, To>();
+        if (site >= counters.size()) {
+            CastRegistry::instance().grow(counters, site + 1);
+        }
+        CastCounters& c = counters[site];
+
+        bump(c.conversions);
+        intmax_t scaled;
+        if (__builtin_mul_overflow(value, Conv::num, &scaled)) {
+            bump(c.overflows);
+        }
+        if (scaled % Conv::den != 0) {
+            bump(c.truncations);
+        }
+        return scaled / Conv::den;
+    }
+
+  }
+
+  /*
+   * Counts of every pair of ratios converted so far, merged over all threads
+   */
+
+  inline std::vector<CastStats> castStats() {
+      return details::CastRegistry::instance().snapshot();
+  }
+
+  inline void resetCastStats() {
+      details::CastRegistry::instance().reset();
+  }
+
+}
+
+#endif // UNITS_INSTRUMENT_H
@@ -0,0 +1,228 @@
+#ifndef UNITS_RANGES_H
+#define UNITS_RANGES_H
+
+#include "Units.h"
+
+#include <iterator>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+
+namespace phy {
+
+  namespace details {
+
+    /*
+     * Element functions used by the views
+     */
+
+    // The element is first scaled by K, which lets a scaling and a cast share a single ratio
+    template<typename To, typename K = std::ratio<1>>
+    struct cast_fn {
+        template<typename U, typename R>
+        To operator()(Qty<U, R> q) const {
+            return qtyCast<To>(Qty<U, std::ratio_multiply<R, K>>(q.value));
+        }
+    };
+
+    // Scaling by a ratio only changes the ratio of the quantity, the value is kept as is
+    template<typename K>
+    struct scale_fn {
+        template<typename U, typename R>
+        Qty<U, std::ratio_multiply<R, K>> operator()(Qty<U, R> q) const {
+            return q.value;
+        }
+    };
+
+    struct plus_fn {
+        template<typename Q1, typename Q2>
+        auto operator()(Q1 q1, Q2 q2) const {
+            return q1 + q2;
+        }
+    };
+
+    struct times_fn {
+        template<typename Q1, typename Q2>
+        auto operator()(Q1 q1, Q2 q2) const {
+            return q1 * q2;
+        }
+    };
+
+    /*
+     * Detection of views that are already a conversion of another range
+     */
+
+    template<typename V>
+    struct is_cast_view : std::false_type {};
+
+    template<typename V, typename To, typename K>
+    struct is_cast_view<std::ranges::transform_view<V, cast_fn<To, K>>> : std::true_type {
+        using target = To;
+        using factor = K;
+    };
+
+    template<typename V>
+    struct is_scale_view : std::false_type {};
+
+    template<typename V, typename K>
+    struct is_scale_view<std::ranges::transform_view<V, scale_fn<K>>> : std::true_type {
+        using factor = K;
+    };
+
+    /*
+     * Lazy element-wise combination of two ranges, stops at the end of the shortest one
+     */
+
+    template<std::ranges::view V1, std::ranges::view V2, typename F>
+      requires std::ranges::forward_range<const V1> && std::ranges::forward_range<const V2>
+    class pairwise_view : public std::ranges::view_interface<pairwise_view<V1, V2, F>> {
+    public:
+      class iterator {
+      public:
+        using iterator_concept = std::forward_iterator_tag;
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::decay_t<std::invoke_result_t<F,
+          std::ranges::range_reference_t<const V1>, std::ranges::range_reference_t<const V2>>>;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+        iterator(std::ranges::iterator_t<const V1> it1, std::ranges::iterator_t<const V2> it2)
+        : it1(it1), it2(it2) {}
+
+        value_type operator*() const {
+            return F{}(*it1, *it2);
+        }
+
+        iterator& operator++() {
+            ++it1;
+            ++it2;
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        bool operator==(const iterator& other) const {
+            return it1 == other.it1;
+        }
+
+        std::ranges::iterator_t<const V1> it1;
+        std::ranges::iterator_t<const V2> it2;
+      };
+
+      struct sentinel {
+        std::ranges::sentinel_t<const V1> end1;
+        std::ranges::sentinel_t<const V2> end2;
+
+        friend bool operator==(const iterator& it, const sentinel& s) {
+            return it.it1 == s.end1 || it.it2 == s.end2;
+        }
+      };
+
+      pairwise_view() = default;
+      pairwise_view(V1 base1, V2 base2) : base1(std::move(base1)), base2(std::move(base2)) {}
+
+      iterator begin() const {
+          return iterator(std::ranges::begin(base1), std::ranges::begin(base2));
+      }
+
+      sentinel end() const {
+          return sentinel{std::ranges::end(base1), std::ranges::end(base2)};
+      }
+
+    private:
+      V1 base1;
+      V2 base2;
+    };
+
+    /*
+     * Adaptors usable both as a call and after a pipe
+     */
+
+    template<typename Derived>
+    struct adaptor {
+        template<std::ranges::viewable_range R>
+        friend auto operator|(R&& r, const Derived& self) {
+            return self(std::forward<R>(r));
+        }
+    };
+
+    template<typename F, std::ranges::viewable_range ROther>
+    struct pairwise_adaptor : adaptor<pairwise_adaptor<F, ROther>> {
+        std::views::all_t<ROther> other;
+
+        explicit pairwise_adaptor(ROther&& other) : other(std::views::all(std::forward<ROther>(other))) {}
+
+        template<std::ranges::viewable_range R>
+        auto operator()(R&& r) const {
+            using V = std::views::all_t<R>;
+            return pairwise_view<V, std::views::all_t<ROther>, F>(std::views::all(std::forward<R>(r)), other);
+        }
+    };
+
+    template<typename To>
+    struct qty_cast_adaptor : adaptor<qty_cast_adaptor<To>> {
+        // Casting an already converted range goes straight from the original ratio
+        template<std::ranges::viewable_range R>
+        auto operator()(R&& r) const {
+            using V = std::remove_cvref_t<R>;
+            if constexpr (is_cast_view<V>::value || is_scale_view<V>::value) {
+                using factor = typename std::conditional_t<is_cast_view<V>::value, is_cast_view<V>, is_scale_view<V>>::factor;
+                return std::views::transform(std::forward<R>(r).base(), cast_fn<To, factor>{});
+            } else {
+                return std::views::transform(std::forward<R>(r), cast_fn<To>{});
+            }
+        }
+    };
+
+    template<typename K>
+    struct scale_adaptor : adaptor<scale_adaptor<K>> {
+        // Successive scalings are merged into a single ratio
+        template<std::ranges::viewable_range R>
+        auto operator()(R&& r) const {
+            using V = std::remove_cvref_t<R>;
+            if constexpr (is_scale_view<V>::value) {
+                using factor = std::ratio_multiply<typename is_scale_view<V>::factor, K>;
+                return std::views::transform(std::forward<R>(r).base(), scale_fn<factor>{});
+            } else {
+                return std::views::transform(std::forward<R>(r), scale_fn<K>{});
+            }
+        }
+    };
+
+  }
+
+  namespace views {
+
+    /*
+     * Lazy views over ranges of quantities, nothing is computed until iteration
+     */
+
+    // Converts every element of the range to the quantity To
+    template<typename To>
+    inline constexpr details::qty_cast_adaptor<To> qty_cast{};
+
+    // Multiplies every element of the range by the constant ratio K
+    template<typename K>
+    inline constexpr details::scale_adaptor<K> scale{};
+
+    // Element-wise sum with another range
+    template<std::ranges::viewable_range ROther>
+    auto plus(ROther&& other) {
+        return details::pairwise_adaptor<details::plus_fn, ROther>(std::forward<ROther>(other));
+    }
+
+    // Element-wise product with another range
+    template<std::ranges::viewable_range ROther>
+    auto times(ROther&& other) {
+        return details::pairwise_adaptor<details::times_fn, ROther>(std::forward<ROther>(other));
+    }
+
+  }
+
+}
+
+#endif // UNITS_RANGES_H
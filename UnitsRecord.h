@@ -0,0 +1,377 @@
+#ifndef UNITS_RECORD_H
+#define UNITS_RECORD_H
+
+#include "Units.h"
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace phy {
+
+  /*
+   * Fields of a record: a quantity along with the integer type storing its value
+   */
+
+  template<typename Q, typename T>
+  struct Field {
+    using Quantity = Q;
+    using Rep = T;
+  };
+
+  namespace details {
+
+    template<intmax_t Lo, intmax_t Hi, typename T>
+    inline constexpr bool fits_in = Lo >= std::numeric_limits<T>::min() && Hi <= std::numeric_limits<T>::max();
+
+    template<intmax_t Lo, intmax_t Hi>
+    using smallest_int =
+      std::conditional_t<fits_in<Lo, Hi, int8_t>, int8_t,
+      std::conditional_t<fits_in<Lo, Hi, int16_t>, int16_t,
+      std::conditional_t<fits_in<Lo, Hi, int32_t>, int32_t, intmax_t>>>;
+
+    // A plain quantity is a field of full width
+    template<typename F>
+    struct field_traits {
+      using Quantity = F;
+      using Rep = intmax_t;
+
+      static constexpr intmax_t min = std::numeric_limits<intmax_t>::min();
+      static constexpr intmax_t max = std::numeric_limits<intmax_t>::max();
+    };
+
+    template<typename Q, typename T>
+    struct field_traits<Field<Q, T>> {
+      using Quantity = Q;
+      using Rep = T;
+
+      static constexpr intmax_t min = std::numeric_limits<T>::min();
+      static constexpr intmax_t max = std::numeric_limits<T>::max();
+    };
+
+    /*
+     * Widest fields first, so that no padding is needed between them
+     */
+
+    template<typename... F>
+    struct record_layout {
+      static constexpr std::size_t count = sizeof...(F);
+      static constexpr std::array<std::size_t, count> sizes = { sizeof(typename field_traits<F>::Rep)... };
+
+      static constexpr std::size_t align = [] {
+          std::size_t res = 1;
+          for (std::size_t s : sizes) {
+              res = s > res ? s : res;
+          }
+          return res;
+      }();
+
+      // Fields of the same width keep their order
+      static constexpr std::array<std::size_t, count> offsets = [] {
+          std::array<std::size_t, count> res = {};
+          std::size_t pos = 0;
+          for (std::size_t width = align; width > 0; width /= 2) {
+              for (std::size_t i = 0; i < count; ++i) {
+                  if (sizes[i] == width) {
+                      res[i] = pos;
+                      pos += width;
+                  }
+              }
+          }
+          return res;
+      }();
+
+      static constexpr std::size_t size = [] {
+          std::size_t res = 0;
+          for (std::size_t s : sizes) {
+              res += s;
+          }
+          return (res + align - 1) / align * align;
+      }();
+    };
+
+  }
+
+  // Stored in the smallest integer type holding every value in [Lo, Hi], values outside are rejected
+  template<typename Q, intmax_t Lo, intmax_t Hi>
+  struct Bounded {
+    static_assert(Lo <= Hi, "Bounded requires Lo <= Hi");
+
+    using Quantity = Q;
+    using Rep = details::smallest_int<Lo, Hi>;
+  };
+
+  namespace details {
+
+    template<typename Q, intmax_t Lo, intmax_t Hi>
+    struct field_traits<Bounded<Q, Lo, Hi>> {
+      using Quantity = Q;
+      using Rep = smallest_int<Lo, Hi>;
+
+      static constexpr intmax_t min = Lo;
+      static constexpr intmax_t max = Hi;
+    };
+
+  }
+
+  /*
+   * A row of quantities packed in as few bytes as their widths allow
+   */
+
+  template<typename... F>
+  class QtyRecord {
+    static_assert(sizeof...(F) > 0, "QtyRecord requires at least one field");
+    static_assert((std::is_signed_v<typename details::field_traits<F>::Rep> && ...), "QtyRecord requires signed integer representations");
+
+    using Layout = details::record_layout<F...>;
+
+  public:
+    static constexpr std::size_t fields = sizeof...(F);
+
+    template<std::size_t I>
+    using FieldQty = typename details::field_traits<std::tuple_element_t<I, std::tuple<F...>>>::Quantity;
+
+    template<std::size_t I>
+    using FieldRep = typename details::field_traits<std::tuple_element_t<I, std::tuple<F...>>>::Rep;
+
+    // Whether a value is in the range of a field: the bounds of a Bounded, the width of a Field
+    template<std::size_t I>
+    static constexpr bool fits(intmax_t value) {
+        using Traits = details::field_traits<std::tuple_element_t<I, std::tuple<F...>>>;
+        return value >= Traits::min && value <= Traits::max;
+    }
+
+    // Every checked store goes through here, a value out of range throws std::out_of_range
+    template<std::size_t I>
+    static FieldRep<I> narrow(intmax_t value) {
+        if (!fits<I>(value)) {
+            throw std::out_of_range("value out of the range of its record field");
+        }
+        return static_cast<FieldRep<I>>(value);
+    }
+
+    // For hot loops whose values are known to fit, only checked by an assert
+    template<std::size_t I>
+    static FieldRep<I> narrowUnchecked(intmax_t value) {
+        assert(fits<I>(value) && "value out of the range of its record field");
+        return static_cast<FieldRep<I>>(value);
+    }
+
+    QtyRecord() = default;
+
+    explicit QtyRecord(typename details::field_traits<F>::Quantity... values) {
+        setAll(std::index_sequence_for<F...>(), values...);
+    }
+
+    template<std::size_t I>
+    FieldQty<I> get() const {
+        FieldRep<I> rep;
+        std::memcpy(&rep, bytes + Layout::offsets[I], sizeof(rep));
+        return FieldQty<I>(rep);
+    }
+
+    template<std::size_t I>
+    void set(FieldQty<I> q) {
+        store<I>(narrow<I>(q.value));
+    }
+
+    template<std::size_t I>
+    void setUnchecked(FieldQty<I> q) {
+        store<I>(narrowUnchecked<I>(q.value));
+    }
+
+  private:
+    template<std::size_t I>
+    void store(FieldRep<I> rep) {
+        std::memcpy(bytes + Layout::offsets[I], &rep, sizeof(rep));
+    }
+
+    template<std::size_t... I>
+    void setAll(std::index_sequence<I...>, typename details::field_traits<F>::Quantity... values) {
+        (set<I>(values), ...);
+    }
+
+    alignas(Layout::align) std::byte bytes[Layout::size] = {};
+  };
+
+  /*
+   * Batches of records, one record after the other or one column per field
+   */
+
+  enum class RecordLayout {
+    RowMajor,
+    ColumnMajor,
+  };
+
+  template<typename... F>
+  class QtyRows {
+  public:
+    using Record = QtyRecord<F...>;
+
+    std::size_t size() const {
+        return rows.size();
+    }
+
+    void resize(std::size_t n) {
+        rows.resize(n);
+    }
+
+    void push_back(const Record& record) {
+        rows.push_back(record);
+    }
+
+    Record record(std::size_t row) const {
+        return rows[row];
+    }
+
+    template<std::size_t I>
+    typename Record::template FieldQty<I> get(std::size_t row) const {
+        return rows[row].template get<I>();
+    }
+
+    template<std::size_t I>
+    void set(std::size_t row, typename Record::template FieldQty<I> q) {
+        rows[row].template set<I>(q);
+    }
+
+    template<std::size_t I>
+    void setUnchecked(std::size_t row, typename Record::template FieldQty<I> q) {
+        rows[row].template setUnchecked<I>(q);
+    }
+
+  private:
+    std::vector<Record> rows;
+  };
+
+  template<typename... F>
+  class QtyColumns {
+  public:
+    using Record = QtyRecord<F...>;
+
+    std::size_t size() const {
+        return std::get<0>(columns).size();
+    }
+
+    void resize(std::size_t n) {
+        std::apply([n](auto&... column) { (column.resize(n), ...); }, columns);
+    }
+
+    void push_back(const Record& record) {
+        pushAll(record, std::index_sequence_for<F...>());
+    }
+
+    Record record(std::size_t row) const {
+        return recordAt(row, std::index_sequence_for<F...>());
+    }
+
+    template<std::size_t I>
+    typename Record::template FieldQty<I> get(std::size_t row) const {
+        return typename Record::template FieldQty<I>(std::get<I>(columns)[row]);
+    }
+
+    template<std::size_t I>
+    void set(std::size_t row, typename Record::template FieldQty<I> q) {
+        std::get<I>(columns)[row] = Record::template narrow<I>(q.value);
+    }
+
+    template<std::size_t I>
+    void setUnchecked(std::size_t row, typename Record::template FieldQty<I> q) {
+        std::get<I>(columns)[row] = Record::template narrowUnchecked<I>(q.value);
+    }
+
+    // Raw values of one field, in the ratio of its quantity
+    template<std::size_t I>
+    std::span<typename Record::template FieldRep<I>> column() {
+        return std::get<I>(columns);
+    }
+
+    template<std::size_t I>
+    std::span<const typename Record::template FieldRep<I>> column() const {
+        return std::get<I>(columns);
+    }
+
+  private:
+    template<std::size_t... I>
+    void pushAll(const Record& record, std::index_sequence<I...>) {
+        (std::get<I>(columns).push_back(Record::template narrow<I>(record.template get<I>().value)), ...);
+    }
+
+    template<std::size_t... I>
+    Record recordAt(std::size_t row, std::index_sequence<I...>) const {
+        return Record(get<I>(row)...);
+    }
+
+    std::tuple<std::vector<typename details::field_traits<F>::Rep>...> columns;
+  };
+
+  template<RecordLayout L, typename... F>
+  using QtyBatch = std::conditional_t<L == RecordLayout::RowMajor, QtyRows<F...>, QtyColumns<F...>>;
+
+  /*
+   * Per field qtyCast of a record or a whole batch
+   */
+
+  namespace details {
+
+    template<typename ToRecord, typename FromRecord, std::size_t... I>
+    ToRecord recordCast(const FromRecord& from, std::index_sequence<I...>) {
+        return ToRecord(qtyCast<typename ToRecord::template FieldQty<I>>(from.template get<I>())...);
+    }
+
+    // One plain loop per column, the conversion is the same for the whole column and a value
+    // out of the range of its new field throws std::out_of_range
+    template<std::size_t I, typename ToBatch, typename FromBatch>
+    void castColumn(const FromBatch& from, ToBatch& to) {
+        using FromQty = typename FromBatch::Record::template FieldQty<I>;
+        using ToQty = typename ToBatch::Record::template FieldQty<I>;
+
+        const auto src = from.template column<I>();
+        const auto dst = to.template column<I>();
+        for (std::size_t row = 0; row < src.size(); ++row) {
+            dst[row] = ToBatch::Record::template narrow<I>(qtyCast<ToQty>(FromQty(src[row])).value);
+        }
+    }
+
+    template<typename ToBatch, typename FromBatch, std::size_t... I>
+    void castColumns(const FromBatch& from, ToBatch& to, std::index_sequence<I...>) {
+        (castColumn<I>(from, to), ...);
+    }
+
+  }
+
+  template<typename ToRecord, typename... F>
+  ToRecord recordCast(const QtyRecord<F...>& from) {
+      static_assert(ToRecord::fields == sizeof...(F), "recordCast requires records with the same number of fields");
+      return details::recordCast<ToRecord>(from, std::index_sequence_for<F...>());
+  }
+
+  template<typename ToBatch, typename FromBatch>
+  ToBatch batchCast(const FromBatch& from) {
+      using FromRecord = typename FromBatch::Record;
+      using ToRecord = typename ToBatch::Record;
+      static_assert(ToRecord::fields == FromRecord::fields, "batchCast requires records with the same number of fields");
+
+      ToBatch to;
+      if constexpr (requires { from.template column<0>(); std::declval<ToBatch&>().template column<0>(); }) {
+          to.resize(from.size());
+          details::castColumns(from, to, std::make_index_sequence<FromRecord::fields>());
+      } else {
+          for (std::size_t row = 0; row < from.size(); ++row) {
+              to.push_back(recordCast<ToRecord>(from.record(row)));
+          }
+      }
+      return to;
+  }
+
+}
+
+#endif // UNITS_RECORD_H
@@ -0,0 +1,40 @@
+#!/bin/sh
+#
+# Compile-time benchmark for Units.h
+#
+# Generates a translation unit with COUNT functions, each multiplying and dividing
+# quantities of pseudo-random units, then reports compile time and object sizes.
+#
+# Usage: ./benchCompile.sh [COUNT] (the compiler is taken from $CXX)
+
+set -e
+
+COUNT=${1:-2000}
+CXX=${CXX:-c++}
+ROOT=$(cd "$(dirname "$0")" && pwd)
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+awk -v count="$COUNT" 'BEGIN {
+    srand(1);
+    print "#include \"Units.h\"";
+    print "namespace bench {";
+    for (i = 0; i < count; ++i) {
+        a = ""; b = "";
+        for (j = 0; j < 7; ++j) {
+            a = a (j ? ", " : "") (int(rand() * 7) - 3);
+            b = b (j ? ", " : "") (int(rand() * 7) - 3);
+        }
+        printf "  auto f%d(phy::Qty<phy::Unit<%s>> x, phy::Qty<phy::Unit<%s>> y) { return (x * y) / x * (y / y); }\n", i, a, b;
+    }
+    print "}";
+}' > "$DIR/bench.cc"
+
+START=$(date +%s%N)
+"$CXX" -std=c++20 -O0 -c -I "$ROOT" "$DIR/bench.cc" -o "$DIR/bench.o"
+STOP=$(date +%s%N)
+
+echo "functions:        $COUNT"
+echo "compile time:     $(( (STOP - START) / 1000000 )) ms"
+echo "object size:      $(wc -c < "$DIR/bench.o") bytes"
+echo "symbol names:     $(nm "$DIR/bench.o" | awk '{ total += length($NF) } END { print total }') bytes"
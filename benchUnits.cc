@@ -0,0 +1,72 @@
+#include "Units.h"
+#include "UnitsAlgorithm.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+/*
+ * Small benchmarks comparing the specialized algorithms with the standard ones
+ */
+
+namespace {
+
+  constexpr std::size_t Count = 1 << 22;
+
+  template<typename Fn>
+  double timeMs(Fn fn) {
+      const auto start = std::chrono::steady_clock::now();
+      fn();
+      const auto stop = std::chrono::steady_clock::now();
+      return std::chrono::duration<double, std::milli>(stop - start).count();
+  }
+
+  template<typename Q>
+  std::vector<Q> randomReadings(std::size_t count, std::mt19937_64& gen) {
+      std::uniform_int_distribution<intmax_t> dist(-1000000000, 1000000000);
+      std::vector<Q> res;
+      res.reserve(count);
+      for (std::size_t i = 0; i < count; ++i) {
+          res.emplace_back(dist(gen));
+      }
+      return res;
+  }
+
+  void benchSort() {
+      std::mt19937_64 gen(42);
+      const auto feet = randomReadings<phy::Foot>(Count / 2, gen);
+      const auto inches = randomReadings<phy::Inch>(Count / 4, gen);
+      const auto millis = randomReadings<phy::Qty<phy::Metre, std::milli>>(Count / 4, gen);
+
+      std::vector<phy::Foot> stdFeet = feet;
+      const double stdSort = timeMs([&] { std::sort(stdFeet.begin(), stdFeet.end()); });
+
+      std::vector<phy::Foot> radixFeet = feet;
+      const double radix = timeMs([&] { phy::radixSort(radixFeet); });
+
+      // Mixed readings converted to their common ratio then sorted with operator<
+      using Common = phy::Qty<phy::Metre, std::ratio<1, 5000>>;
+      std::vector<Common> mixed;
+      const double stdMixed = timeMs([&] {
+          mixed.reserve(Count);
+          for (auto q : feet) mixed.push_back(phy::qtyCast<Common>(q));
+          for (auto q : inches) mixed.push_back(phy::qtyCast<Common>(q));
+          for (auto q : millis) mixed.push_back(phy::qtyCast<Common>(q));
+          std::sort(mixed.begin(), mixed.end());
+      });
+
+      std::vector<Common> common;
+      const double radixMixed = timeMs([&] { common = phy::sortedCommon(feet, inches, millis); });
+
+      std::printf("sort %zu Foot:    std::sort %8.2f ms, radixSort    %8.2f ms\n", feet.size(), stdSort, radix);
+      std::printf("sort %zu mixed:   std::sort %8.2f ms, sortedCommon %8.2f ms\n", mixed.size(), stdMixed, radixMixed);
+  }
+
+}
+
+int main() {
+    benchSort();
+    return 0;
+}
@@ -0,0 +1,65 @@
+#!/bin/sh
+#
+# Zero-overhead check for Units.h
+#
+# Compiles codegenUnits.cc at -O2 and compares, for every qty_X function, its number
+# of instructions with the one of raw_X. Fails if a quantity version is longer, or if
+# it calls or jumps to a symbol raw_X does not, as a helper left out of line would.
+#
+# Usage: ./checkCodegen.sh [SOURCE] (the compiler is taken from $CXX)
+
+set -e
+
+CXX=${CXX:-c++}
+ROOT=$(cd "$(dirname "$0")" && pwd)
+SRC=${1:-$ROOT/codegenUnits.cc}
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+"$CXX" -std=c++20 -O2 -S -fno-asynchronous-unwind-tables -I "$ROOT" "$SRC" -o "$DIR/codegen.s"
+
+# Count the instructions of each function, directives and labels excluded
+awk '
+  /^[A-Za-z_][A-Za-z0-9_]*:/ { fn = substr($1, 1, length($1) - 1); next }
+  /^[ \t]*\./ || /^[ \t]*$/ || /^\.L/ { next }
+  fn != "" { count[fn]++ }
+  END { for (f in count) print f, count[f] }
+' "$DIR/codegen.s" | sort > "$DIR/counts"
+
+# Symbols called or jumped to by each function, local labels excluded
+awk '
+  /^[A-Za-z_][A-Za-z0-9_]*:/ { fn = substr($1, 1, length($1) - 1); next }
+  fn != "" && $1 ~ /^(call|jmp)/ && $2 !~ /^\.L/ { print fn, $2 }
+' "$DIR/codegen.s" | sort -u > "$DIR/calls"
+
+STATUS=0
+CHECKED=0
+for QTY in $(awk '$1 ~ /^qty_/ { print $1 }' "$DIR/counts"); do
+    NAME=${QTY#qty_}
+    QTY_COUNT=$(awk -v f="$QTY" '$1 == f { print $2 }' "$DIR/counts")
+    RAW_COUNT=$(awk -v f="raw_$NAME" '$1 == f { print $2 }' "$DIR/counts")
+    if [ -z "$RAW_COUNT" ]; then
+        echo "FAIL $NAME: no raw_$NAME to compare with"
+        STATUS=1
+    elif [ "$QTY_COUNT" -gt "$RAW_COUNT" ]; then
+        echo "FAIL $NAME: $QTY_COUNT instructions instead of $RAW_COUNT"
+        STATUS=1
+    elif EXTRA=$(awk -v q="$QTY" -v r="raw_$NAME" '
+             $1 == r { raw[$2] = 1 }
+             $1 == q { calls[$2] = 1 }
+             END { for (c in calls) if (!(c in raw)) { print c; found = 1 } exit !found }
+         ' "$DIR/calls"); then
+        echo "FAIL $NAME: calls $(echo $EXTRA) unlike raw_$NAME"
+        STATUS=1
+    else
+        echo "ok   $NAME: $QTY_COUNT instructions"
+    fi
+    CHECKED=$((CHECKED + 1))
+done
+
+if [ "$CHECKED" -eq 0 ]; then
+    echo "FAIL no function checked"
+    STATUS=1
+fi
+
+exit $STATUS
@@ -0,0 +1,109 @@
+#include "Units.h"
+#include "UnitsChrono.h"
+
+/*
+ * Pairs of functions compiled by checkCodegen.sh: each qty_X must not take more
+ * instructions than the hand-written raw_X computing the same thing on intmax_t
+ */
+
+using namespace phy::literals;
+
+using Millimetre = phy::Qty<phy::Metre, std::milli>;
+
+extern "C" {
+
+  /*
+   * Casts
+   */
+
+  intmax_t qty_cast_foot_inch(intmax_t v) { return phy::qtyCast<phy::Inch>(phy::Foot(v)).value; }
+  intmax_t raw_cast_foot_inch(intmax_t v) { return v * 12; }
+
+  intmax_t qty_cast_milli_metre(intmax_t v) { return phy::qtyCast<phy::Length>(Millimetre(v)).value; }
+  intmax_t raw_cast_milli_metre(intmax_t v) { return v / 1000; }
+
+  intmax_t qty_cast_metre_mile(intmax_t v) { return phy::qtyCast<phy::Mile>(phy::Length(v)).value; }
+  intmax_t raw_cast_metre_mile(intmax_t v) { return v * 125 / 201168; }
+
+  /*
+   * Comparisons, mixed ratios are compared in their exact common ratio
+   */
+
+  bool qty_eq_same(intmax_t a, intmax_t b) { return phy::Length(a) == phy::Length(b); }
+  bool raw_eq_same(intmax_t a, intmax_t b) { return a == b; }
+
+  bool qty_eq_metre_milli(intmax_t a, intmax_t b) { return phy::Length(a) == Millimetre(b); }
+  bool raw_eq_metre_milli(intmax_t a, intmax_t b) { return a * 1000 == b; }
+
+  bool qty_eq_foot_milli(intmax_t a, intmax_t b) { return phy::Foot(a) == Millimetre(b); }
+  bool raw_eq_foot_milli(intmax_t a, intmax_t b) { return a * 1524 == b * 5; }
+
+  bool qty_ne_metre_milli(intmax_t a, intmax_t b) { return phy::Length(a) != Millimetre(b); }
+  bool raw_ne_metre_milli(intmax_t a, intmax_t b) { return a * 1000 != b; }
+
+  bool qty_lt_metre_milli(intmax_t a, intmax_t b) { return phy::Length(a) < Millimetre(b); }
+  bool raw_lt_metre_milli(intmax_t a, intmax_t b) { return a * 1000 < b; }
+
+  bool qty_le_metre_milli(intmax_t a, intmax_t b) { return phy::Length(a) <= Millimetre(b); }
+  bool raw_le_metre_milli(intmax_t a, intmax_t b) { return a * 1000 <= b; }
+
+  bool qty_gt_metre_milli(intmax_t a, intmax_t b) { return phy::Length(a) > Millimetre(b); }
+  bool raw_gt_metre_milli(intmax_t a, intmax_t b) { return a * 1000 > b; }
+
+  bool qty_ge_metre_milli(intmax_t a, intmax_t b) { return phy::Length(a) >= Millimetre(b); }
+  bool raw_ge_metre_milli(intmax_t a, intmax_t b) { return a * 1000 >= b; }
+
+  /*
+   * Arithmetic
+   */
+
+  intmax_t qty_plus_metre_milli(intmax_t a, intmax_t b) { return (phy::Length(a) + Millimetre(b)).value; }
+  intmax_t raw_plus_metre_milli(intmax_t a, intmax_t b) { return a * 1000 + b; }
+
+  intmax_t qty_minus_metre_milli(intmax_t a, intmax_t b) { return (phy::Length(a) - Millimetre(b)).value; }
+  intmax_t raw_minus_metre_milli(intmax_t a, intmax_t b) { return a * 1000 - b; }
+
+  intmax_t qty_plus_assign(intmax_t a, intmax_t b) { phy::Qty<phy::Metre, std::milli> q(a); q += phy::Length(b); return q.value; }
+  intmax_t raw_plus_assign(intmax_t a, intmax_t b) { return a + b * 1000; }
+
+  intmax_t qty_minus_assign(intmax_t a, intmax_t b) { phy::Qty<phy::Metre, std::milli> q(a); q -= phy::Length(b); return q.value; }
+  intmax_t raw_minus_assign(intmax_t a, intmax_t b) { return a - b * 1000; }
+
+  intmax_t qty_times(intmax_t a, intmax_t b) { return (phy::Length(a) * phy::Time(b)).value; }
+  intmax_t raw_times(intmax_t a, intmax_t b) { return a * b; }
+
+  intmax_t qty_times_milli(intmax_t a, intmax_t b) { return (Millimetre(a) * Millimetre(b)).value; }
+  intmax_t raw_times_milli(intmax_t a, intmax_t b) { return a * b; }
+
+  intmax_t qty_divide(intmax_t a, intmax_t b) { return (phy::Length(a) / phy::Time(b)).value; }
+  intmax_t raw_divide(intmax_t a, intmax_t b) { return a / b; }
+
+  intmax_t qty_divide_milli(intmax_t a, intmax_t b) { return (Millimetre(a) / phy::Qty<phy::Second, std::milli>(b)).value; }
+  intmax_t raw_divide_milli(intmax_t a, intmax_t b) { return a / b; }
+
+  /*
+   * std::chrono, the difference of two clock readings is used as is
+   */
+
+  intmax_t qty_speed_between_readings(intmax_t d, intmax_t t1, intmax_t t2) {
+      using Clock = std::chrono::steady_clock;
+      const phy::Timestamp<Clock> r1 = Clock::time_point(Clock::duration(t1));
+      const phy::Timestamp<Clock> r2 = Clock::time_point(Clock::duration(t2));
+      return (phy::Length(d) / (r2 - r1)).value;
+  }
+  intmax_t raw_speed_between_readings(intmax_t d, intmax_t t1, intmax_t t2) { return d / (t2 - t1); }
+
+  intmax_t qty_divide_duration(intmax_t a, intmax_t b) { return (phy::Length(a) / std::chrono::milliseconds(b)).value; }
+  intmax_t raw_divide_duration(intmax_t a, intmax_t b) { return a / b; }
+
+  /*
+   * Literals
+   */
+
+  intmax_t qty_literal_metres() { return (42_metres).value; }
+  intmax_t raw_literal_metres() { return 42; }
+
+  intmax_t qty_literal_celsius() { return (10_celsius).value; }
+  intmax_t raw_literal_celsius() { return 283; }
+
+}
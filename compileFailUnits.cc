@@ -0,0 +1,18 @@
+#include "Units.h"
+
+/*
+ * Units whose exponents leave [-127, 127], each case must be rejected at compile time
+ *
+ * Built by ctest with -DCASE=n, the test passes when the compiler reports the exponent range
+ */
+
+using Big = phy::Qty<phy::Unit<100, 0, 0, 0, 0, 0, 0>>;
+using Small = phy::Qty<phy::Unit<0, 0, -70, 0, 0, 0, 0>>;
+
+#if CASE == 1
+auto product = Big(1) * Big(1);
+#elif CASE == 2
+auto quotient = Big(1) / phy::Qty<phy::Unit<-100, 0, 0, 0, 0, 0, 0>>(1);
+#elif CASE == 3
+auto power = phy::pow<2>(Small(1));
+#endif
@@ -1,9 +1,21 @@
-#include "Units.h"
-
+#include <algorithm>
 #include <iostream>
+#include <span>
+#include <thread>
+#include <vector>
 
 #include <gtest/gtest.h>
 
+#include "Units.h"
+#include "UnitsAlgorithm.h"
+#include "UnitsChrono.h"
+#include "UnitsExact.h"
+#include "UnitsExpression.h"
+#include "UnitsFormula.h"
+#include "UnitsHistogram.h"
+#include "UnitsRanges.h"
+#include "UnitsRecord.h"
+
 /*
  * Basic tests to make sure initialization is correct
  */
@@ -27,6 +39,24 @@ TEST(basicUnitTest, Volt) {
   EXPECT_EQ(phy::Metre::candela, 0);
 }
 
+TEST(basicUnitTest, packedNegativeExponents) {
+  using U = phy::Unit<-127, 127, -1, 0, 1, -64, 3>;
+
+  EXPECT_EQ(U::metre, -127);
+  EXPECT_EQ(U::kilogram, 127);
+  EXPECT_EQ(U::second, -1);
+  EXPECT_EQ(U::ampere, 0);
+  EXPECT_EQ(U::kelvin, 1);
+  EXPECT_EQ(U::mole, -64);
+  EXPECT_EQ(U::candela, 3);
+}
+TEST(basicUnitTest, packedProduct) {
+  const auto res = phy::ElectricPotential(1) / phy::Current(1);
+
+  EXPECT_TRUE((std::is_same_v<decltype(res)::Unit, phy::Ohm>));
+  EXPECT_TRUE((std::is_same_v<decltype(res)::Unit, phy::PackedUnit<phy::Volt::dims - phy::Ampere::dims>>));
+}
+
 /*
  * Basic comparaison operators
  */
@@ -457,6 +487,17 @@ TEST(quantityMultiplicatingTest, HertzTimesSecond) {
   EXPECT_EQ(res.value,20);
 }
 
+TEST(quantityMultiplicatingTest, MilliTimesMilli) {
+  phy::Qty<phy::Metre, std::milli> l1(30);
+  phy::Qty<phy::Metre, std::milli> l2(20);
+
+  auto res = l1 * l2;
+
+  EXPECT_EQ(decltype(res)::Unit::metre, 2);
+  EXPECT_TRUE((std::is_same_v<decltype(res)::Ratio, std::micro>));
+  EXPECT_EQ(res.value, 600);
+}
+
 TEST(quantityDividingTest, LengthDividedByTime1) {
   phy::Length l(100000);
   phy::Time s(3600);
@@ -555,6 +596,15 @@ TEST(weirdQuantitiesEqualityTest, mileYard) {
 
   EXPECT_TRUE(m == y);
 }
+TEST(weirdQuantitiesEqualityTest, footMillimetreExact) {
+  const phy::Foot f(1);
+  const phy::Qty<phy::Metre, std::milli> m1(304);
+  const phy::Qty<phy::Metre, std::milli> m2(305);
+
+  EXPECT_FALSE(f == m1);
+  EXPECT_TRUE(f > m1);
+  EXPECT_TRUE(f < m2);
+}
 TEST(weirdQuantitiesEqualityTest, additionEquals) {
   const phy::Inch i1(6);
   const phy::Inch i2(6);
@@ -620,6 +670,738 @@ TEST(weirdQuantitiesSubtractingTest, conversion) {
   EXPECT_EQ(i2.value, 11);
 }
 
+/*
+ * Testing powers and roots
+ */
+
+TEST(quantityPowTest, squareLength) {
+  const phy::Qty<phy::Metre, std::milli> l(30);
+  const auto a = phy::pow<2>(l);
+
+  EXPECT_EQ(decltype(a)::Unit::metre, 2);
+  EXPECT_TRUE((std::is_same_v<decltype(a)::Ratio, std::micro>));
+  EXPECT_EQ(a.value, 900);
+}
+TEST(quantityPowTest, zeroExponent) {
+  const phy::Time t(7);
+  const auto res = phy::pow<0>(t);
+
+  EXPECT_EQ(decltype(res)::Unit::second, 0);
+  EXPECT_EQ(res.value, 1);
+}
+
+TEST(quantitySqrtTest, areaToLength) {
+  const phy::Length l1(12);
+  const auto l2 = phy::sqrt(l1 * l1);
+
+  EXPECT_TRUE((std::is_same_v<decltype(l2), const phy::Length>));
+  EXPECT_EQ(l2.value, 12);
+}
+TEST(quantitySqrtTest, roundsDown) {
+  const phy::Qty<phy::Unit<2, 0, -2, 0, 0, 0, 0>> s(99);
+  const auto res = phy::sqrt(s);
+
+  EXPECT_TRUE((std::is_same_v<decltype(res), const phy::MeterSecond>));
+  EXPECT_EQ(res.value, 9);
+}
+TEST(quantitySqrtTest, ratio) {
+  const phy::Qty<phy::Unit<2, 0, 0, 0, 0, 0, 0>, std::micro> a(250000);
+  const auto l = phy::sqrt(a);
+
+  EXPECT_TRUE((std::is_same_v<decltype(l)::Ratio, std::milli>));
+  EXPECT_EQ(l.value, 500);
+}
+TEST(quantitySqrtTest, largeValue) {
+  const phy::Qty<phy::Unit<2, 0, 0, 0, 0, 0, 0>> a(INTMAX_MAX);
+
+  EXPECT_EQ(phy::sqrt(a).value, 3037000499);
+}
+
+TEST(quantityCbrtTest, volumeToLength) {
+  const phy::Qty<phy::Unit<3, 0, 0, 0, 0, 0, 0>, std::kilo> v(-125);
+  const auto l = phy::cbrt(v);
+
+  EXPECT_EQ(decltype(l)::Unit::metre, 1);
+  EXPECT_TRUE((std::is_same_v<decltype(l)::Ratio, std::deca>));
+  EXPECT_EQ(l.value, -5);
+}
+
+TEST(quantityBulkTest, norm) {
+  const std::vector<phy::Length> v { phy::Length(3), phy::Length(4) };
+
+  EXPECT_EQ(phy::norm(v.begin(), v.end()).value, 5);
+}
+TEST(quantityBulkTest, rms) {
+  const phy::Foot v[] { phy::Foot(1), phy::Foot(7), phy::Foot(7), phy::Foot(1) };
+  const auto res = phy::rms(std::begin(v), std::end(v));
+
+  EXPECT_TRUE((std::is_same_v<decltype(res), const phy::Foot>));
+  EXPECT_EQ(res.value, 5);
+}
+TEST(quantityBulkTest, squaresBeyondIntmax) {
+  using Millimetre = phy::Qty<phy::Metre, std::milli>;
+  const std::vector<Millimetre> v(4, Millimetre(4000000000));
+
+  EXPECT_EQ(phy::norm(v.begin(), v.end()).value, 8000000000);
+  EXPECT_EQ(phy::rms(v.begin(), v.end()).value, 4000000000);
+
+  const std::vector<phy::Length> huge(4, phy::Length(INTMAX_MAX));
+  EXPECT_EQ(phy::norm(huge.begin(), huge.end()).value, INTMAX_MAX);
+  EXPECT_EQ(phy::rms(huge.begin(), huge.end()).value, INTMAX_MAX);
+
+  // Four squares of INTMAX_MIN make 2^128, the sum saturates instead of wrapping to zero
+  const std::vector<phy::Length> lowest(4, phy::Length(INTMAX_MIN));
+  EXPECT_EQ(phy::norm(lowest.begin(), lowest.end()).value, INTMAX_MAX);
+  EXPECT_EQ(phy::rms(lowest.begin(), lowest.end()).value, INTMAX_MAX);
+
+  const std::vector<phy::Length> many(1000, phy::Length(INTMAX_MAX - 1));
+  EXPECT_EQ(phy::norm(many.begin(), many.end()).value, INTMAX_MAX);
+  EXPECT_EQ(phy::rms(many.begin(), many.end()).value, INTMAX_MAX - 1);
+}
+TEST(quantityBulkTest, rmsEmpty) {
+  const std::vector<phy::Length> v;
+
+  EXPECT_EQ(phy::rms(v.begin(), v.end()).value, 0);
+}
+
+/*
+ * Testing range views
+ */
+
+TEST(quantityViewsTest, qtyCast) {
+  const std::vector<phy::Qty<phy::Metre, std::milli>> v { 1000, 2500, 300 };
+  const std::vector<phy::Qty<phy::Metre, std::centi>> expected { 100, 250, 30 };
+  auto res = v | phy::views::qty_cast<phy::Qty<phy::Metre, std::centi>>;
+
+  EXPECT_TRUE(std::ranges::equal(res, expected));
+}
+TEST(quantityViewsTest, chainedCastCollapses) {
+  const std::vector<phy::Qty<phy::Metre, std::milli>> v { 1500, 2500 };
+  auto res = v | phy::views::qty_cast<phy::Length> | phy::views::qty_cast<phy::Qty<phy::Metre, std::centi>>;
+
+  EXPECT_TRUE((std::is_same_v<decltype(res),
+    decltype(v | phy::views::qty_cast<phy::Qty<phy::Metre, std::centi>>)>));
+  EXPECT_EQ((*res.begin()).value, 150);
+}
+TEST(quantityViewsTest, scale) {
+  const std::vector<phy::Length> v { 1, 2 };
+  auto res = v | phy::views::scale<std::kilo> | phy::views::scale<std::milli>;
+
+  EXPECT_TRUE((std::is_same_v<std::ranges::range_value_t<decltype(res)>, phy::Length>));
+  EXPECT_EQ((*res.begin()).value, 1);
+}
+TEST(quantityViewsTest, scaleThenCast) {
+  const std::vector<phy::Length> v { 3 };
+  auto res = v | phy::views::scale<std::kilo> | phy::views::qty_cast<phy::Length>;
+
+  EXPECT_EQ((*res.begin()).value, 3000);
+}
+TEST(quantityViewsTest, castThenScale) {
+  const std::vector<phy::Qty<phy::Metre, std::milli>> v { 1500 };
+  auto res = v | phy::views::qty_cast<phy::Length> | phy::views::scale<std::kilo>;
+
+  EXPECT_TRUE((std::is_same_v<std::ranges::range_value_t<decltype(res)>, phy::Qty<phy::Metre, std::kilo>>));
+  EXPECT_EQ((*res.begin()).value, 1);
+}
+TEST(quantityViewsTest, plus) {
+  const std::vector<phy::Foot> f { 1, 2, 3 };
+  const std::vector<phy::Inch> i { 1, 2 };
+  std::vector<intmax_t> values;
+  for (auto q : f | phy::views::plus(i)) {
+    values.push_back(q.value);
+  }
+
+  EXPECT_EQ(values, (std::vector<intmax_t>{ 13, 26 }));
+}
+TEST(quantityViewsTest, times) {
+  const std::vector<phy::Length> l { 2, 3 };
+  const std::vector<phy::Time> t { 4, 5 };
+  auto res = phy::views::times(t)(l);
+
+  EXPECT_EQ(decltype((*res.begin()))::Unit::second, 1);
+  EXPECT_EQ((*std::ranges::next(res.begin())).value, 15);
+}
+
+/*
+ * Testing sorting, searching and merging
+ */
+
+TEST(quantitySortTest, radixSortNegative) {
+  std::vector<phy::Length> v { 5, -3, 0, INTMAX_MIN, 42, -300, INTMAX_MAX, 7 };
+  phy::radixSort(v);
+
+  EXPECT_TRUE(std::is_sorted(v.begin(), v.end()));
+  EXPECT_EQ(v.front().value, INTMAX_MIN);
+  EXPECT_EQ(v.back().value, INTMAX_MAX);
+}
+TEST(quantitySortTest, radixSortParallel) {
+  std::vector<phy::Length> v;
+  std::vector<intmax_t> expected;
+  for (intmax_t i = 0; i < (1 << 19); ++i) {
+    const intmax_t x = (i * 2654435761) % 1000003 - 500000;
+    v.emplace_back(x);
+    expected.push_back(x);
+  }
+  phy::radixSort(std::span(v));
+  std::sort(expected.begin(), expected.end());
+
+  EXPECT_TRUE(std::equal(v.begin(), v.end(), expected.begin(), [](phy::Length l, intmax_t x) { return l.value == x; }));
+}
+TEST(quantitySortTest, sortedCommon) {
+  const std::vector<phy::Foot> f { 2, -1 };
+  const std::vector<phy::Qty<phy::Metre, std::milli>> mm { 305, 300 };
+  const auto res = phy::sortedCommon(f, mm);
+
+  EXPECT_TRUE((std::is_same_v<decltype(res)::value_type::Ratio, std::ratio<1, 5000>>));
+  EXPECT_EQ(res.size(), 4u);
+  EXPECT_EQ(res[0].value, -1524);
+  EXPECT_EQ(res[1].value, 1500);
+  EXPECT_EQ(res[2].value, 1525);
+  EXPECT_EQ(res[3].value, 3048);
+}
+
+TEST(quantitySearchTest, lowerBoundExact) {
+  const std::vector<phy::Inch> v { 1, 6, 12, 13, 24 };
+  const auto it = phy::lowerBound(v, phy::Foot(1));
+
+  EXPECT_EQ(it - v.begin(), 2);
+}
+TEST(quantitySearchTest, lowerBoundRoundsUp) {
+  const std::vector<phy::Length> v { -2, -1, 0, 1, 2 };
+
+  EXPECT_EQ(phy::lowerBound(v, phy::Qty<phy::Metre, std::milli>(500)) - v.begin(), 3);
+  EXPECT_EQ(phy::lowerBound(v, phy::Qty<phy::Metre, std::milli>(-500)) - v.begin(), 2);
+}
+
+TEST(quantityMergeTest, footInch) {
+  const std::vector<phy::Foot> f { 1, 2 };
+  const std::vector<phy::Inch> i { 6, 13, 30 };
+  const auto res = phy::merge(f, i);
+
+  EXPECT_TRUE((std::is_same_v<decltype(res)::value_type, phy::Inch>));
+  const std::vector<intmax_t> expected { 6, 12, 13, 24, 30 };
+  EXPECT_TRUE(std::equal(res.begin(), res.end(), expected.begin(), [](phy::Inch q, intmax_t x) { return q.value == x; }));
+}
+
+/*
+ * Testing histograms
+ */
+
+using Latency = phy::Qty<phy::Second, std::micro>;
+
+TEST(quantityHistogramTest, fixedBins) {
+  phy::FixedHistogram<Latency, phy::Qty<phy::Second, std::milli>(5), 10> h;
+  h.record(Latency(0));
+  h.record(Latency(4999));
+  h.record(Latency(5000));
+  h.record(Latency(-3));
+  h.record(Latency(1000000000));
+
+  EXPECT_EQ(h.count(0), 3u);
+  EXPECT_EQ(h.count(1), 1u);
+  EXPECT_EQ(h.count(9), 1u);
+  EXPECT_EQ(h.total(), 5u);
+  EXPECT_TRUE((h.lowerBound(3) == phy::Qty<phy::Second, std::milli>(15)));
+}
+TEST(quantityHistogramTest, fixedBinsPressure) {
+  phy::FixedHistogram<phy::Pressure, phy::Qty<phy::Pascal, std::kilo>(1), 4> h;
+  h.record(phy::Pressure(2500));
+
+  EXPECT_EQ(h.count(2), 1u);
+}
+TEST(quantityHistogramTest, logLinearBins) {
+  using Bins = phy::LogLinearBins<Latency, Latency(1), 2>;
+
+  EXPECT_EQ(Bins::index(Latency(3)), 3u);
+  EXPECT_EQ(Bins::index(Latency(4)), 4u);
+  EXPECT_EQ(Bins::index(Latency(7)), 7u);
+  EXPECT_EQ(Bins::index(Latency(8)), 8u);
+  EXPECT_EQ(Bins::index(Latency(9)), 8u);
+  EXPECT_EQ(Bins::index(Latency(10)), 9u);
+  EXPECT_EQ(Bins::lowerBound(9).value, 10);
+  EXPECT_LT(Bins::index(Latency(INTMAX_MAX)), Bins::size);
+}
+TEST(quantityHistogramTest, coarseSamplesDoNotOverflow) {
+  using Coarse = phy::Qty<phy::Second, std::milli>;
+
+  phy::FixedHistogram<Coarse, Latency(1), 10> fixed;
+  fixed.record(Coarse(INTMAX_MAX));
+  fixed.record(Coarse(INTMAX_MAX / 1000 + 1));
+  fixed.record(Coarse(INTMAX_MAX / 1000));
+  EXPECT_EQ(fixed.count(9), 3u);
+
+  phy::LogLinearHistogram<Coarse, Latency(1)> logLinear;
+  logLinear.record(Coarse(INTMAX_MAX / 10));
+  logLinear.record(Coarse(INTMAX_MAX));
+  EXPECT_EQ(logLinear.count(logLinear.size() - 1), 2u);
+  EXPECT_LT(decltype(logLinear)::Bins::index(Coarse(INTMAX_MAX / 1000)), logLinear.size());
+}
+TEST(quantityHistogramTest, logLinearBoundsMatchIndex) {
+  using Bins = phy::LogLinearBins<Latency, Latency(1), 3>;
+
+  for (std::size_t bin = 0; bin < 200; ++bin) {
+    EXPECT_EQ(Bins::index(Bins::lowerBound(bin)), bin);
+  }
+}
+TEST(quantityHistogramTest, merge) {
+  phy::LogLinearHistogram<Latency, phy::Qty<phy::Second, std::milli>(1)> h1;
+  phy::LogLinearHistogram<Latency, phy::Qty<phy::Second, std::milli>(1)> h2;
+  h1.record(Latency(2500));
+  h2.record(Latency(2999));
+  h1 += h2;
+
+  EXPECT_EQ(h1.count(2), 2u);
+}
+TEST(quantityHistogramTest, sharded) {
+  using Bins = phy::FixedBins<Latency, Latency(10), 8>;
+  phy::ShardedHistogram<Bins, 4> h;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&h, t] {
+      for (int i = 0; i < 1000; ++i) {
+        h.record(Latency(t * 10));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const auto snapshot = h.snapshot();
+
+  EXPECT_EQ(snapshot.total(), 4000u);
+  EXPECT_EQ(snapshot.count(3), 1000u);
+}
+
+/*
+ * Testing units spelled as strings
+ */
+
+TEST(unitExpressionTest, baseUnits) {
+  EXPECT_TRUE((std::is_same_v<phy::unit<"m">, phy::Metre>));
+  EXPECT_TRUE((std::is_same_v<phy::unit<"kg">, phy::Kilogram>));
+  EXPECT_TRUE((std::is_same_v<phy::unit<"mol">, phy::Mole>));
+  EXPECT_TRUE((std::is_same_v<phy::unit<"cd">, phy::Candela>));
+}
+TEST(unitExpressionTest, derivedUnits) {
+  EXPECT_TRUE((std::is_same_v<phy::unit<"kg*m/s^2">, phy::Newton>));
+  EXPECT_TRUE((std::is_same_v<phy::unit<"N">, phy::Newton>));
+  EXPECT_TRUE((std::is_same_v<phy::unit<"m.kg.s^-2">, phy::Newton>));
+  EXPECT_TRUE((std::is_same_v<phy::unit<"kg / (m * s^2)">, phy::Pascal>));
+  EXPECT_TRUE((std::is_same_v<phy::unit<"V/A">, phy::Ohm>));
+  EXPECT_TRUE((std::is_same_v<phy::unit<"1/s">, phy::Hertz>));
+}
+TEST(unitExpressionTest, prefixes) {
+  EXPECT_TRUE((std::is_same_v<phy::qtyOf<"km">, phy::Qty<phy::Metre, std::kilo>>));
+  EXPECT_TRUE((std::is_same_v<phy::qtyOf<"ms">, phy::Qty<phy::Second, std::milli>>));
+  EXPECT_TRUE((std::is_same_v<phy::qtyOf<"g">, phy::Qty<phy::Kilogram, std::milli>>));
+  EXPECT_TRUE((std::is_same_v<phy::qtyOf<"kg">, phy::Mass>));
+  EXPECT_TRUE((std::is_same_v<phy::qtyOf<"hPa">, phy::Qty<phy::Pascal, std::hecto>>));
+  EXPECT_TRUE((std::is_same_v<phy::qtyOf<"dam">, phy::Qty<phy::Metre, std::deca>>));
+  EXPECT_TRUE((std::is_same_v<phy::qtyOf<"mm^2">, phy::Qty<phy::Unit<2, 0, 0, 0, 0, 0, 0>, std::micro>>));
+}
+TEST(unitExpressionTest, nonSiUnits) {
+  EXPECT_TRUE((std::is_same_v<phy::qtyOf<"km/h">, phy::Qty<phy::Speed, std::ratio<5, 18>>>));
+  EXPECT_TRUE((std::is_same_v<phy::qtyOf<"min">, phy::Qty<phy::Second, std::ratio<60>>>));
+}
+TEST(unitExpressionTest, usableAsQuantity) {
+  const phy::qtyOf<"km/h"> v(36);
+  const phy::MeterSecond s(10);
+
+  EXPECT_TRUE(v == s);
+}
+
+/*
+ * Testing the formula engine
+ */
+
+TEST(formulaTest, power) {
+  phy::FormulaEngine engine;
+  engine.declare<phy::ElectricPotential>("voltage");
+  engine.declare<phy::Current>("current");
+  engine.declare<phy::Power>("power");
+  const phy::Formula f = engine.compile("power = voltage * current");
+
+  const std::vector<intmax_t> voltage { 230, 12, 5 };
+  const std::vector<intmax_t> current { 2, 3, 0 };
+  std::vector<intmax_t> power(3);
+  f.evaluate({ { "voltage", voltage }, { "current", current } }, power);
+
+  EXPECT_EQ(f.target(), "power");
+  EXPECT_EQ(f.bytecode().size(), 1u);
+  EXPECT_EQ(power, (std::vector<intmax_t>{ 460, 36, 0 }));
+}
+TEST(formulaTest, ratioFoldedAtTheEnd) {
+  phy::FormulaEngine engine;
+  engine.declare<phy::Length>("distance");
+  engine.declare<phy::Time>("time");
+  engine.declare<phy::Qty<phy::Speed, std::ratio<5, 18>>>("speed");
+  const phy::Formula f = engine.compile("speed = distance / time");
+
+  const std::vector<intmax_t> distance { 100, 50 };
+  const std::vector<intmax_t> time { 10, 5 };
+  const std::vector<std::span<const intmax_t>> columns { distance, time };
+  std::vector<intmax_t> speed(2);
+  f.evaluate(columns, speed);
+
+  EXPECT_EQ(f.bytecode().size(), 2u);
+  EXPECT_EQ(speed, (std::vector<intmax_t>{ 36, 36 }));
+}
+TEST(formulaTest, mixedRatios) {
+  phy::FormulaEngine engine;
+  engine.declare<phy::Qty<phy::Metre, std::milli>>("a");
+  engine.declare<phy::Foot>("b");
+  engine.declare<phy::Qty<phy::Metre, std::milli>>("total");
+  const phy::Formula f = engine.compile("total = (a + b) * 2 - a");
+
+  const std::vector<intmax_t> a { 1000 };
+  const std::vector<intmax_t> b { 10 };
+  std::vector<intmax_t> total(1);
+  f.evaluate({ { "a", a }, { "b", b } }, total);
+
+  EXPECT_EQ(f.inputs().size(), 2u);
+  EXPECT_EQ(total[0], 1000 + 2 * 3048);
+}
+TEST(formulaTest, constantsFolded) {
+  phy::FormulaEngine engine;
+  engine.declare<phy::Length>("x");
+  engine.declare<phy::Length>("y");
+  const phy::Formula f = engine.compile("y = x * (2 * 3 + 4) / 5");
+
+  const std::vector<intmax_t> x { 7 };
+  std::vector<intmax_t> y(1);
+  f.evaluate({ { "x", x } }, y);
+
+  EXPECT_EQ(f.bytecode().size(), 2u);
+  EXPECT_EQ(y[0], 14);
+}
+TEST(formulaTest, errors) {
+  phy::FormulaEngine engine;
+  engine.declare<phy::Length>("distance");
+  engine.declare<phy::Time>("time");
+  engine.declare<phy::MeterSecond>("speed");
+
+  EXPECT_THROW(engine.compile("speed = distance + time"), phy::FormulaError);
+  EXPECT_THROW(engine.compile("speed = distance * time"), phy::FormulaError);
+  EXPECT_THROW(engine.compile("speed = distance / duration"), phy::FormulaError);
+  EXPECT_THROW(engine.compile("speed = distance / (time"), phy::FormulaError);
+  EXPECT_THROW(engine.compile("speed = distance / 0"), phy::FormulaError);
+}
+
+/*
+ * Testing the bridge with std::chrono
+ */
+
+TEST(chronoTest, durations) {
+  using namespace std::chrono_literals;
+
+  EXPECT_TRUE((std::is_same_v<decltype(phy::fromDuration(5ms)), phy::Qty<phy::Second, std::milli>>));
+  EXPECT_EQ(phy::fromDuration(1500ms).value, 1500);
+  EXPECT_EQ(phy::toDuration(phy::Qty<phy::Second, std::micro>(42)), 42us);
+  EXPECT_EQ(phy::toDuration(phy::fromDuration(3min)), 3min);
+}
+TEST(chronoTest, mixedWithQuantities) {
+  using namespace std::chrono_literals;
+
+  auto speed = phy::Length(3000) / 1500ms;
+  EXPECT_TRUE((std::is_same_v<decltype(speed)::Unit, phy::Speed>));
+  EXPECT_EQ(phy::qtyCast<phy::MeterSecond>(speed).value, 2000);
+
+  auto distance = phy::MeterSecond(3) * 2min;
+  EXPECT_EQ(phy::qtyCast<phy::Length>(distance).value, 360);
+}
+TEST(chronoTest, rateOverClockReadings) {
+  using Clock = std::chrono::steady_clock;
+  using namespace std::chrono_literals;
+
+  const phy::Timestamp<Clock> t1 = Clock::time_point(10s);
+  const phy::Timestamp<Clock> t2 = Clock::time_point(14s);
+
+  // With the nanosecond period of the clock, the plain division truncates to zero
+  EXPECT_EQ(phy::qtyCast<phy::MeterSecond>(phy::Length(100) / (t2 - t1)).value, 0);
+
+  const auto speed = phy::rate(phy::Length(100), t2 - t1);
+  EXPECT_TRUE((std::is_same_v<decltype(speed), const phy::MeterSecond>));
+  EXPECT_EQ(speed.value, 25);
+
+  EXPECT_EQ(phy::rate(phy::Length(3), 1500ms).value, 2);
+
+  const auto kmh = phy::rate(phy::Qty<phy::Metre, std::kilo>(90), 1h);
+  EXPECT_EQ(kmh.value, 90);
+  EXPECT_EQ(phy::qtyCast<phy::MeterSecond>(kmh).value, 25);
+}
+TEST(chronoTest, timestamps) {
+  using Clock = std::chrono::steady_clock;
+  using namespace std::chrono_literals;
+
+  const phy::Timestamp<Clock> t1 = Clock::time_point(10s);
+  const phy::Timestamp<Clock> t2 = Clock::time_point(14s);
+  EXPECT_TRUE((std::is_same_v<decltype(t2 - t1), phy::Qty<phy::Second, Clock::period>>));
+  EXPECT_EQ(phy::qtyCast<phy::Time>(t2 - t1).value, 4);
+
+  // Readings in whole seconds, so that the division does not truncate to zero
+  const phy::Timestamp<Clock, std::ratio<1>> s1 = t1.timePoint();
+  const phy::Timestamp<Clock, std::ratio<1>> s2 = t2.timePoint();
+  auto speed = phy::Length(100) / (s2 - s1);
+  EXPECT_TRUE((std::is_same_v<decltype(speed), phy::MeterSecond>));
+  EXPECT_EQ(speed.value, 25);
+
+  EXPECT_LT(t1, t2);
+  EXPECT_EQ(t1 + phy::Time(4), t2);
+  EXPECT_EQ((t2 - phy::Qty<phy::Second, std::milli>(4000)), t1);
+  EXPECT_EQ(t2.timePoint(), Clock::time_point(14s));
+
+  const phy::Timestamp<Clock, std::milli> coarse = Clock::time_point(1234567us);
+  EXPECT_EQ(coarse.sinceEpoch.value, 1234);
+  EXPECT_LE(t2, phy::Timestamp<Clock>::now());
+}
+
+/*
+ * Testing packed records
+ */
+
+using SensorRecord = phy::QtyRecord<
+  phy::Bounded<phy::Length, 0, 100000>,
+  phy::Field<phy::Mass, int16_t>,
+  phy::Temperature,
+  phy::Bounded<phy::Pressure, -100, 100>>;
+
+TEST(recordTest, packedLayout) {
+  EXPECT_TRUE((std::is_same_v<SensorRecord::FieldRep<0>, int32_t>));
+  EXPECT_TRUE((std::is_same_v<SensorRecord::FieldRep<2>, intmax_t>));
+  EXPECT_TRUE((std::is_same_v<SensorRecord::FieldRep<3>, int8_t>));
+  EXPECT_EQ(sizeof(SensorRecord), 16u);
+  EXPECT_EQ(alignof(SensorRecord), 8u);
+  EXPECT_EQ(sizeof(phy::QtyRecord<phy::Field<phy::Length, int16_t>, phy::Field<phy::Time, int8_t>>), 4u);
+}
+TEST(recordTest, getAndSet) {
+  SensorRecord record(phy::Length(99999), phy::Mass(-300), phy::Temperature(293), phy::Pressure(-100));
+  EXPECT_EQ(record.get<0>().value, 99999);
+  EXPECT_EQ(record.get<1>().value, -300);
+  EXPECT_EQ(record.get<2>().value, 293);
+  EXPECT_EQ(record.get<3>().value, -100);
+
+  record.set<1>(phy::Mass(12));
+  EXPECT_EQ(record.get<1>().value, 12);
+  EXPECT_EQ(record.get<0>().value, 99999);
+  EXPECT_EQ(phy::QtyRecord<phy::Length>().get<0>().value, 0);
+}
+TEST(recordTest, ranges) {
+  EXPECT_TRUE(SensorRecord::fits<3>(-100));
+  EXPECT_TRUE(SensorRecord::fits<3>(100));
+  EXPECT_FALSE(SensorRecord::fits<3>(101));
+  EXPECT_TRUE(SensorRecord::fits<1>(INT16_MIN));
+  EXPECT_FALSE(SensorRecord::fits<1>(INT16_MAX + 1));
+
+  SensorRecord record;
+  record.set<3>(phy::Pressure(-100));
+  EXPECT_EQ(record.get<3>().value, -100);
+  record.set<3>(phy::Pressure(100));
+  EXPECT_EQ(record.get<3>().value, 100);
+  record.set<1>(phy::Mass(INT16_MIN));
+  EXPECT_EQ(record.get<1>().value, INT16_MIN);
+
+  EXPECT_THROW(record.set<3>(phy::Pressure(101)), std::out_of_range);
+  EXPECT_THROW(record.set<1>(phy::Mass(INT16_MAX + 1)), std::out_of_range);
+  EXPECT_THROW(SensorRecord(phy::Length(-1), phy::Mass(0), phy::Temperature(0), phy::Pressure(0)), std::out_of_range);
+  EXPECT_EQ(record.get<3>().value, 100);
+  EXPECT_EQ(record.get<1>().value, INT16_MIN);
+
+  record.setUnchecked<3>(phy::Pressure(-7));
+  EXPECT_EQ(record.get<3>().value, -7);
+  EXPECT_DEBUG_DEATH(record.setUnchecked<3>(phy::Pressure(101)), "out of the range");
+
+  phy::QtyColumns<phy::Field<phy::Length, int32_t>> wide;
+  wide.push_back(decltype(wide)::Record(phy::Length(40)));
+  EXPECT_THROW(wide.set<0>(0, phy::Length(INT32_MAX + intmax_t(1))), std::out_of_range);
+  EXPECT_EQ(wide.get<0>(0).value, 40);
+  EXPECT_DEBUG_DEATH(wide.setUnchecked<0>(0, phy::Length(INT32_MAX + intmax_t(1))), "out of the range");
+
+  using Narrow = phy::QtyColumns<phy::Field<phy::Qty<phy::Metre, std::centi>, int8_t>>;
+  EXPECT_THROW(phy::batchCast<Narrow>(wide), std::out_of_range);
+  using NarrowRows = phy::QtyRows<phy::Field<phy::Qty<phy::Metre, std::centi>, int8_t>>;
+  EXPECT_THROW(phy::batchCast<NarrowRows>(wide), std::out_of_range);
+}
+TEST(recordTest, columns) {
+  phy::QtyBatch<phy::RecordLayout::ColumnMajor, phy::Field<phy::Length, int32_t>, phy::Field<phy::Time, int16_t>> batch;
+  batch.push_back(decltype(batch)::Record(phy::Length(10), phy::Time(1)));
+  batch.push_back(decltype(batch)::Record(phy::Length(20), phy::Time(2)));
+  batch.set<1>(1, phy::Time(4));
+
+  EXPECT_EQ(batch.size(), 2u);
+  EXPECT_EQ(batch.get<0>(1).value, 20);
+  EXPECT_EQ(batch.record(1).get<1>().value, 4);
+  EXPECT_EQ(batch.column<0>()[0], 10);
+  EXPECT_TRUE((std::is_same_v<decltype(batch.column<1>()), std::span<int16_t>>));
+}
+TEST(recordTest, casts) {
+  using Metric = phy::QtyRecord<phy::Field<phy::Length, int32_t>, phy::Field<phy::Mass, int32_t>>;
+  using Fine = phy::QtyRecord<phy::Qty<phy::Metre, std::milli>, phy::Field<phy::Qty<phy::Kilogram, std::kilo>, int16_t>>;
+
+  const Fine fine = phy::recordCast<Fine>(Metric(phy::Length(3), phy::Mass(4500)));
+  EXPECT_EQ(fine.get<0>().value, 3000);
+  EXPECT_EQ(fine.get<1>().value, 4);
+
+  phy::QtyRows<phy::Field<phy::Length, int32_t>, phy::Field<phy::Mass, int32_t>> rows;
+  for (int i = 0; i < 100; ++i) {
+    rows.push_back(Metric(phy::Length(i), phy::Mass(1000 * i)));
+  }
+
+  auto columns = phy::batchCast<phy::QtyColumns<phy::Qty<phy::Metre, std::milli>, phy::Field<phy::Qty<phy::Kilogram, std::kilo>, int16_t>>>(rows);
+  ASSERT_EQ(columns.size(), 100u);
+  EXPECT_EQ(columns.get<0>(42).value, 42000);
+  EXPECT_EQ(columns.get<1>(42).value, 42);
+
+  auto back = phy::batchCast<phy::QtyColumns<phy::Field<phy::Length, int32_t>, phy::Field<phy::Mass, int32_t>>>(columns);
+  ASSERT_EQ(back.size(), 100u);
+  EXPECT_EQ(back.get<0>(99).value, 99);
+  EXPECT_EQ(back.get<1>(99).value, 99000);
+}
+
+/*
+ * Testing exact quantities
+ */
+
+TEST(exactTest, noTruncationInChains) {
+  EXPECT_EQ(((phy::Length(10) / phy::Time(3)) * phy::Time(3)).value, 9);
+
+  auto speed = phy::exact(phy::Length(10)) / phy::exact(phy::Time(3));
+  auto distance = speed * phy::exact(phy::Time(3));
+  EXPECT_EQ(phy::qtyCast<phy::Length>(distance).value, 10);
+  EXPECT_EQ(phy::qtyCast<phy::MeterSecond>(speed).value, 3);
+  EXPECT_EQ((phy::qtyCast<phy::Qty<phy::Speed, std::milli>>(speed).value), 3333);
+}
+TEST(exactTest, lazyNormalization) {
+  phy::ExactQty<phy::Metre> third(1, 3);
+  auto sum = third + third + third;
+  EXPECT_EQ(sum.num, 3);
+  EXPECT_EQ(sum.den, 3);
+  EXPECT_EQ(sum.normalized().num, 1);
+  EXPECT_EQ(sum.normalized().den, 1);
+  EXPECT_EQ(sum, phy::exact(phy::Length(1)));
+
+  phy::ExactQty<phy::Metre> half(-1, -2);
+  EXPECT_EQ(half.num, 1);
+  EXPECT_EQ(half.den, 2);
+  EXPECT_TRUE((std::is_same_v<decltype(third - half), phy::ExactQty<phy::Metre>>));
+  EXPECT_EQ(third - half, phy::ExactQty<phy::Metre>(-1, 6));
+}
+TEST(exactTest, mixedRatios) {
+  auto total = phy::exact(phy::Foot(1)) + phy::exact(phy::Inch(1));
+  EXPECT_EQ(phy::qtyCast<phy::Inch>(total).value, 13);
+  EXPECT_EQ((phy::qtyCast<phy::Qty<phy::Metre, std::micro>>(total).value), 330200);
+
+  auto exactInch = phy::qtyCast<phy::ExactQty<phy::Metre, std::milli>>(phy::exact(phy::Inch(1)));
+  EXPECT_EQ(exactInch.num * 5, exactInch.den * 127);
+
+  EXPECT_LT(phy::exact(phy::Inch(11)), phy::exact(phy::Foot(1)));
+  EXPECT_GT(phy::exact(phy::Inch(13)), phy::exact(phy::Foot(1)));
+  EXPECT_EQ(phy::exact(phy::Inch(12)), phy::exact(phy::Foot(1)));
+}
+TEST(exactTest, reducedOnlyWhenOverflowing) {
+  phy::ExactQty<phy::Metre> x(1);
+  for (int i = 0; i < 100; ++i) {
+    x = phy::qtyCast<phy::ExactQty<phy::Metre>>(x * phy::ExactQty<phy::Radian>(1000003, 1000033) / phy::ExactQty<phy::Radian>(1000003, 1000033));
+  }
+  EXPECT_EQ(x, phy::exact(phy::Length(1)));
+  EXPECT_EQ(phy::qtyCast<phy::Length>(x).value, 1);
+}
+TEST(exactTest, reducedInLowestTerms) {
+  const intmax_t pow3 = 205891132094649;    // 3^30
+  const intmax_t pow5 = 95367431640625;     // 5^20
+  const auto product = phy::ExactQty<phy::Metre>(pow3, pow3) * phy::ExactQty<phy::Radian>(pow5);
+  EXPECT_EQ(product.num, pow5);
+  EXPECT_EQ(product.den, 1);
+  EXPECT_EQ(phy::qtyCast<phy::Length>(product).value, pow5);
+
+  const intmax_t big = INTMAX_MAX / 3;
+  const auto sum = phy::ExactQty<phy::Metre>(big, pow3) + phy::ExactQty<phy::Metre>(big, 2 * pow3);
+  EXPECT_EQ(sum.num, 1537228672809129301);
+  EXPECT_EQ(sum.den, 68630377364883);
+  const auto diff = phy::ExactQty<phy::Metre>(big, 7) - phy::ExactQty<phy::Metre>(big - 1, 5);
+  EXPECT_EQ(diff.num, -6148914691236517197);
+  EXPECT_EQ(diff.den, 35);
+
+  EXPECT_THROW(phy::ExactQty<phy::Metre>(big) * phy::ExactQty<phy::Radian>(5), std::overflow_error);
+  EXPECT_THROW(phy::ExactQty<phy::Metre>(big, 3) + phy::ExactQty<phy::Metre>(big, 5), std::overflow_error);
+}
+TEST(exactTest, comparisonOfLargeNumerators) {
+  const intmax_t big = INTMAX_MAX / 3;
+  EXPECT_LT(phy::ExactQty<phy::Metre>(big, 7), phy::ExactQty<phy::Metre>(big, 5));
+  EXPECT_GT(phy::ExactQty<phy::Metre>(big, 5), phy::ExactQty<phy::Metre>(big - 1, 5));
+  EXPECT_LT(phy::ExactQty<phy::Metre>(-big, 5), phy::ExactQty<phy::Metre>(big, 7));
+  EXPECT_GT(phy::ExactQty<phy::Metre>(big, 11), phy::ExactQty<phy::Metre>(big - 1, 11));
+}
+
+/*
+ * Testing the conversion counters
+ */
+
+#ifdef UNITS_INSTRUMENT
+
+static phy::CastStats castStatsOf(intmax_t fromNum, intmax_t fromDen, intmax_t toNum, intmax_t toDen) {
+  for (const phy::CastStats& stats : phy::castStats()) {
+    if (stats.fromNum == fromNum && stats.fromDen == fromDen && stats.toNum == toNum && stats.toDen == toDen) {
+      return stats;
+    }
+  }
+  return { fromNum, fromDen, toNum, toDen };
+}
+
+TEST(instrumentTest, conversionsAndTruncations) {
+  using Seventh = phy::Qty<phy::Metre, std::ratio<1, 7>>;
+  using Third = phy::Qty<phy::Metre, std::ratio<1, 3>>;
+
+  EXPECT_EQ(phy::qtyCast<Third>(Seventh(14)).value, 6);
+  EXPECT_EQ(phy::qtyCast<Third>(Seventh(10)).value, 4);
+  Third sum(1);
+  sum += Seventh(7);
+
+  const phy::CastStats stats = castStatsOf(1, 7, 1, 3);
+  EXPECT_EQ(stats.conversions, 3u);
+  EXPECT_EQ(stats.truncations, 1u);
+  EXPECT_EQ(stats.overflows, 0u);
+}
+TEST(instrumentTest, overflows) {
+  using Big = phy::Qty<phy::Metre, std::ratio<1000, 11>>;
+  using Small = phy::Qty<phy::Metre, std::ratio<1, 11>>;
+
+  phy::qtyCast<Small>(Big(INTMAX_MAX / 10));
+  phy::qtyCast<Small>(Big(10));
+
+  const phy::CastStats stats = castStatsOf(1000, 11, 1, 11);
+  EXPECT_EQ(stats.conversions, 2u);
+  EXPECT_EQ(stats.overflows, 1u);
+}
+TEST(instrumentTest, mergedOverThreads) {
+  using Thirteenth = phy::Qty<phy::Second, std::ratio<1, 13>>;
+  using Time = phy::Time;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([] {
+      for (int i = 0; i < 1000; ++i) {
+        phy::qtyCast<Time>(Thirteenth(i));
+      }
+    });
+  }
+  // Counts of live threads are read too
+  for (int i = 0; i < 1000; ++i) {
+    phy::qtyCast<Time>(Thirteenth(13 * i));
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  const phy::CastStats stats = castStatsOf(1, 13, 1, 1);
+  EXPECT_EQ(stats.conversions, 5000u);
+  EXPECT_EQ(stats.truncations, 4000u - 4 * 77);
+
+  phy::resetCastStats();
+  EXPECT_EQ(castStatsOf(1, 13, 1, 1).conversions, 0u);
+}
+
+#endif
+
 /*
  * Testing usage of literals
  */